@@ -21,6 +21,8 @@ set(CVAR_MENU_BAR_OPEN "gOpenMenuBar" CACHE STRING "")
 set(CVAR_PREFIX_CONTROLLERS "gControllers" CACHE STRING "")
 set(CVAR_PREFIX_ADVANCED_RESOLUTION "gAdvancedResolution" CACHE STRING "")
 set(CVAR_AUDIO_CHANNELS_SETTING "gAudioChannelsSetting" CACHE STRING "")
+set(CVAR_VERTEX_CACHE_BUDGET "gVertexCacheBudget" CACHE STRING "")
+set(CVAR_RESOURCE_CACHE_BUDGET "gResourceCacheBudget" CACHE STRING "")
 
 add_compile_definitions(
 	CVAR_VSYNC_ENABLED="${CVAR_VSYNC_ENABLED}"
@@ -46,4 +48,6 @@ add_compile_definitions(
 	CVAR_PREFIX_CONTROLLERS="${CVAR_PREFIX_CONTROLLERS}"
 	CVAR_PREFIX_ADVANCED_RESOLUTION="${CVAR_PREFIX_ADVANCED_RESOLUTION}"
 	CVAR_AUDIO_CHANNELS_SETTING="${CVAR_AUDIO_CHANNELS_SETTING}"
+	CVAR_VERTEX_CACHE_BUDGET="${CVAR_VERTEX_CACHE_BUDGET}"
+	CVAR_RESOURCE_CACHE_BUDGET="${CVAR_RESOURCE_CACHE_BUDGET}"
 )
@@ -179,6 +179,10 @@
 #define G_FILLWIDERECT 0x38
 #define G_REGBLENDEDTEX 0x3f
 #define G_MOVEMEM_OTR 0x42
+#define G_MESH_OTR_HASH 0x46
+#define G_MESH_OTR_FILEPATH 0x47
+#define G_VTX_EXT 0x48
+#define G_TRI_INDEXED 0x49
 
 /* GFX Effects */
 
@@ -1866,6 +1870,53 @@ typedef union Gfx {
 #define gsSPBranchListOTRFilePath(dl) gsDma1p(G_DL_OTR_FILEPATH, dl, 0, G_DL_NOPUSH)
 #define gsSPBranchListIndex(dl) gsDma1p(G_DL_INDEX, dl, 0, G_DL_NOPUSH)
 
+/*
+ * Draws a whole Mesh resource (an indexed triangle list) with the current
+ * matrices and render state, regardless of its vertex count.
+ */
+#define gSPMeshOTRFilePath(pkt, path) gDma1p(pkt, G_MESH_OTR_FILEPATH, path, 0, 0)
+#define gsSPMeshOTRFilePath(path) gsDma1p(G_MESH_OTR_FILEPATH, path, 0, 0)
+
+/*
+ * Loads n vertices into the extended vertex arena starting at v0. Unlike
+ * G_VTX this is not limited to the 64 entry vertex buffer, the arena holds
+ * up to 65536 vertices. Takes two Gfx commands.
+ */
+#define gSPVertexExt(pkt, v, n, v0)                 \
+    {                                               \
+        Gfx *_g0 = (Gfx*)(pkt), *_g1 = (Gfx*)(pkt); \
+                                                    \
+        _g0->words.w0 = _SHIFTL(G_VTX_EXT, 24, 8);  \
+        _g0->words.w1 = (uintptr_t)(v);             \
+        _g1->words.w0 = (n);                        \
+        _g1->words.w1 = (v0);                       \
+    }
+
+#define gsSPVertexExt(v, n, v0)             \
+    { {                                     \
+        _SHIFTL(G_VTX_EXT, 24, 8),          \
+        (uintptr_t)(v),                     \
+    } },                                    \
+    {                                       \
+        { (uintptr_t)(n), (uintptr_t)(v0) } \
+    }
+
+/*
+ * Draws n / 3 triangles from a list of u16 indices into the vertex arena
+ * filled by gSPVertexExt. Triangles that use an entry which wasn't loaded
+ * during the current frame are skipped.
+ */
+#define gSPTriIndexed(pkt, idx, n)                                            \
+    _DW({                                                                     \
+        Gfx* _g = (Gfx*)(pkt);                                                \
+                                                                              \
+        _g->words.w0 = (_SHIFTL(G_TRI_INDEXED, 24, 8) | _SHIFTL((n), 0, 24)); \
+        _g->words.w1 = (uintptr_t)(idx);                                      \
+    })
+
+#define gsSPTriIndexed(idx, n) \
+    { (_SHIFTL(G_TRI_INDEXED, 24, 8) | _SHIFTL((n), 0, 24)), (uintptr_t)(idx) }
+
 #define gSPSprite2DBase(pkt, s) gDma1p(pkt, G_SPRITE2D_BASE, s, sizeof(uSprite), 0)
 #define gsSPSprite2DBase(s) gsDma1p(G_SPRITE2D_BASE, s, sizeof(uSprite), 0)
 
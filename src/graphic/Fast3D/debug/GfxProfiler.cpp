@@ -0,0 +1,84 @@
+#include "GfxProfiler.h"
+#include <algorithm>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include "graphic/Fast3D/interpreter.h"
+
+namespace Fast {
+
+void GfxProfiler::BeginFrame() {
+    for (auto& ucode : mCurrentFrame) {
+        std::fill(ucode.begin(), ucode.end(), Counter{ 0, 0 });
+    }
+}
+
+void GfxProfiler::EndFrame() {
+    std::vector<GfxOpcodeStats> frame;
+    uint64_t total = 0;
+
+    for (size_t ucode = 0; ucode < mCurrentFrame.size(); ucode++) {
+        for (size_t op = 0; op < mCurrentFrame[ucode].size(); op++) {
+            const auto& entry = mCurrentFrame[ucode][op];
+            if (entry.count == 0) {
+                continue;
+            }
+
+            const int8_t opcode = static_cast<int8_t>(op);
+            const char* name = GfxGetOpcodeNameForUcode((UcodeHandlers)ucode, opcode);
+            frame.push_back({ (UcodeHandlers)ucode, opcode, name != nullptr ? name : "UNKNOWN", entry.count,
+                              entry.nanoseconds });
+            total += entry.nanoseconds;
+        }
+    }
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mLastFrame = std::move(frame);
+    mLastFrameNanoseconds = total;
+}
+
+std::vector<GfxOpcodeStats> GfxProfiler::GetLastFrame() const {
+    const std::lock_guard<std::mutex> lock(mMutex);
+    return mLastFrame;
+}
+
+uint64_t GfxProfiler::GetLastFrameNanoseconds() const {
+    const std::lock_guard<std::mutex> lock(mMutex);
+    return mLastFrameNanoseconds;
+}
+
+bool GfxProfiler::ExportCsv(const std::string& path) const {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        SPDLOG_ERROR("Failed to open {} for writing the opcode profile", path);
+        return false;
+    }
+
+    file << "ucode,opcode,name,count,nanoseconds\n";
+    for (const auto& entry : GetLastFrame()) {
+        file << GetUcodeName(entry.ucode) << "," << (uint32_t)(uint8_t)entry.opcode << "," << entry.name << ","
+             << entry.count << "," << entry.nanoseconds << "\n";
+    }
+
+    return file.good();
+}
+
+const char* GfxProfiler::GetUcodeName(UcodeHandlers ucode) {
+    switch (ucode) {
+        case ucode_f3db:
+            return "F3DB";
+        case ucode_f3d:
+            return "F3D";
+        case ucode_f3dex:
+            return "F3DEX";
+        case ucode_f3dexb:
+            return "F3DEXB";
+        case ucode_f3dex2:
+            return "F3DEX2";
+        case ucode_s2dex:
+            return "S2DEX";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+} // namespace Fast
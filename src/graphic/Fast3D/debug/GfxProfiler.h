@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "public/bridge/gfxbridge.h"
+
+namespace Fast {
+
+struct GfxOpcodeStats {
+    UcodeHandlers ucode;
+    int8_t opcode;
+    const char* name;
+    uint64_t count;
+    uint64_t nanoseconds;
+};
+
+// Accumulates how many times each opcode ran and how long it took, per microcode, for a single frame.
+// Only fed by the interpreter when built with GFX_OPCODE_PROFILER.
+class GfxProfiler {
+  public:
+    void BeginFrame();
+    void EndFrame();
+
+    inline void Record(UcodeHandlers ucode, int8_t opcode, uint64_t nanoseconds) {
+        auto& entry = mCurrentFrame[ucode][static_cast<uint8_t>(opcode)];
+        entry.count++;
+        entry.nanoseconds += nanoseconds;
+    }
+
+    // Results of the last completed frame, only containing opcodes that were executed.
+    std::vector<GfxOpcodeStats> GetLastFrame() const;
+    uint64_t GetLastFrameNanoseconds() const;
+    bool ExportCsv(const std::string& path) const;
+
+    static const char* GetUcodeName(UcodeHandlers ucode);
+
+  private:
+    struct Counter {
+        uint64_t count;
+        uint64_t nanoseconds;
+    };
+
+    std::array<std::array<Counter, 256>, ucode_max> mCurrentFrame{};
+    std::vector<GfxOpcodeStats> mLastFrame;
+    uint64_t mLastFrameNanoseconds = 0;
+    mutable std::mutex mMutex;
+};
+
+} // namespace Fast
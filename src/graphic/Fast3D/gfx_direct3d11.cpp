@@ -132,6 +132,9 @@ static struct {
 
     std::vector<Framebuffer> framebuffers;
 
+    std::vector<ComPtr<ID3D11Buffer>> retained_vertex_buffers;
+    std::vector<uint32_t> free_retained_vertex_buffers;
+
     // Current state
 
     struct ShaderProgramD3D11* shader_program;
@@ -148,6 +151,7 @@ static struct {
     // Previous states (to prevent setting states needlessly)
 
     struct ShaderProgramD3D11* last_shader_program = nullptr;
+    ID3D11Buffer* last_vertex_buffer = nullptr;
     uint32_t last_vertex_buffer_stride = 0;
     ComPtr<ID3D11BlendState> last_blend_state = nullptr;
     ComPtr<ID3D11ShaderResourceView> last_resource_views[SHADER_MAX_TEXTURES] = { nullptr, nullptr };
@@ -255,6 +259,7 @@ static void gfx_d3d11_init() {
         d3d.context->Flush();
 
         d3d.last_shader_program = nullptr;
+        d3d.last_vertex_buffer = nullptr;
         d3d.last_vertex_buffer_stride = 0;
         d3d.last_blend_state.Reset();
         for (int i = 0; i < SHADER_MAX_TEXTURES; i++) {
@@ -680,8 +685,7 @@ static void gfx_d3d11_set_use_alpha(bool use_alpha) {
     // Already part of the pipeline state from shader info
 }
 
-static void gfx_d3d11_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
-
+static void gfx_d3d11_prepare_draw() {
     if (d3d.last_depth_test != d3d.depth_test || d3d.last_depth_mask != d3d.depth_mask) {
         d3d.last_depth_test = d3d.depth_test;
         d3d.last_depth_mask = d3d.depth_mask;
@@ -777,22 +781,6 @@ static void gfx_d3d11_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
         d3d.context->Unmap(d3d.per_draw_cb.Get(), 0);
     }
 
-    // Set vertex buffer data
-
-    D3D11_MAPPED_SUBRESOURCE ms;
-    ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
-    d3d.context->Map(d3d.vertex_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, buf_vbo, buf_vbo_len * sizeof(float));
-    d3d.context->Unmap(d3d.vertex_buffer.Get(), 0);
-
-    uint32_t stride = d3d.shader_program->num_floats * sizeof(float);
-    uint32_t offset = 0;
-
-    if (d3d.last_vertex_buffer_stride != stride) {
-        d3d.last_vertex_buffer_stride = stride;
-        d3d.context->IASetVertexBuffers(0, 1, d3d.vertex_buffer.GetAddressOf(), &stride, &offset);
-    }
-
     if (d3d.last_shader_program != d3d.shader_program) {
         d3d.last_shader_program = d3d.shader_program;
         d3d.context->IASetInputLayout(d3d.shader_program->input_layout.Get());
@@ -809,10 +797,85 @@ static void gfx_d3d11_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
         d3d.last_primitive_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
         d3d.context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     }
+}
+
+static void gfx_d3d11_bind_vertex_buffer(ID3D11Buffer* buffer) {
+    uint32_t stride = d3d.shader_program->num_floats * sizeof(float);
+    uint32_t offset = 0;
+
+    if (d3d.last_vertex_buffer != buffer || d3d.last_vertex_buffer_stride != stride) {
+        d3d.last_vertex_buffer = buffer;
+        d3d.last_vertex_buffer_stride = stride;
+        d3d.context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+    }
+}
+
+static void gfx_d3d11_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+    gfx_d3d11_prepare_draw();
+
+    // Set vertex buffer data
+
+    D3D11_MAPPED_SUBRESOURCE ms;
+    ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
+    d3d.context->Map(d3d.vertex_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
+    memcpy(ms.pData, buf_vbo, buf_vbo_len * sizeof(float));
+    d3d.context->Unmap(d3d.vertex_buffer.Get(), 0);
+
+    gfx_d3d11_bind_vertex_buffer(d3d.vertex_buffer.Get());
 
     d3d.context->Draw(buf_vbo_num_tris * 3, 0);
 }
 
+static uint32_t gfx_d3d11_new_vertex_buffer() {
+    if (!d3d.free_retained_vertex_buffers.empty()) {
+        uint32_t buffer_id = d3d.free_retained_vertex_buffers.back();
+        d3d.free_retained_vertex_buffers.pop_back();
+        return buffer_id;
+    }
+
+    d3d.retained_vertex_buffers.resize(d3d.retained_vertex_buffers.size() + 1);
+    return (uint32_t)(d3d.retained_vertex_buffers.size() - 1);
+}
+
+static void gfx_d3d11_upload_vertex_buffer(uint32_t buffer_id, const float buf_vbo[], size_t buf_vbo_len) {
+    ComPtr<ID3D11Buffer>& buffer = d3d.retained_vertex_buffers[buffer_id];
+    if (buffer.Get() == d3d.last_vertex_buffer) {
+        d3d.last_vertex_buffer = nullptr;
+    }
+    buffer.Reset();
+
+    D3D11_BUFFER_DESC buffer_desc;
+    ZeroMemory(&buffer_desc, sizeof(D3D11_BUFFER_DESC));
+
+    buffer_desc.Usage = D3D11_USAGE_IMMUTABLE;
+    buffer_desc.ByteWidth = buf_vbo_len * sizeof(float);
+    buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    buffer_desc.CPUAccessFlags = 0;
+    buffer_desc.MiscFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA resource_data;
+    ZeroMemory(&resource_data, sizeof(D3D11_SUBRESOURCE_DATA));
+    resource_data.pSysMem = buf_vbo;
+
+    ThrowIfFailed(d3d.device->CreateBuffer(&buffer_desc, &resource_data, buffer.GetAddressOf()));
+}
+
+static void gfx_d3d11_draw_vertex_buffer(uint32_t buffer_id, size_t buf_vbo_num_tris) {
+    gfx_d3d11_prepare_draw();
+    gfx_d3d11_bind_vertex_buffer(d3d.retained_vertex_buffers[buffer_id].Get());
+
+    d3d.context->Draw(buf_vbo_num_tris * 3, 0);
+}
+
+static void gfx_d3d11_delete_vertex_buffer(uint32_t buffer_id) {
+    ComPtr<ID3D11Buffer>& buffer = d3d.retained_vertex_buffers[buffer_id];
+    if (buffer.Get() == d3d.last_vertex_buffer) {
+        d3d.last_vertex_buffer = nullptr;
+    }
+    buffer.Reset();
+    d3d.free_retained_vertex_buffers.push_back(buffer_id);
+}
+
 static void gfx_d3d11_on_resize() {
     // create_render_target_views(true);
 }
@@ -1258,6 +1321,10 @@ struct GfxRenderingAPI gfx_direct3d11_api = { gfx_d3d11_get_name,
                                               gfx_d3d11_set_scissor,
                                               gfx_d3d11_set_use_alpha,
                                               gfx_d3d11_draw_triangles,
+                                              gfx_d3d11_new_vertex_buffer,
+                                              gfx_d3d11_upload_vertex_buffer,
+                                              gfx_d3d11_draw_vertex_buffer,
+                                              gfx_d3d11_delete_vertex_buffer,
                                               gfx_d3d11_init,
                                               gfx_d3d11_on_resize,
                                               gfx_d3d11_start_frame,
@@ -133,6 +133,8 @@ static struct {
 
     std::vector<struct TextureDataMetal> textures;
     std::vector<FramebufferMetal> framebuffers;
+    std::vector<MTL::Buffer*> retained_vertex_buffers;
+    std::vector<uint32_t> free_retained_vertex_buffers;
     FrameUniforms frame_uniforms;
     CoordUniforms coord_uniforms;
     MTL::Buffer* frame_uniform_buffer;
@@ -557,9 +559,7 @@ static void gfx_metal_set_use_alpha(bool use_alpha) {
     // Already part of the pipeline state from shader info
 }
 
-static void gfx_metal_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
-    NS::AutoreleasePool* autorelease_pool = NS::AutoreleasePool::alloc()->init();
-
+static void gfx_metal_prepare_draw() {
     auto& current_framebuffer = mctx.framebuffers[mctx.current_framebuffer];
 
     if (current_framebuffer.last_depth_test != mctx.depth_test ||
@@ -605,16 +605,6 @@ static void gfx_metal_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
         current_framebuffer.command_encoder->setDepthBias(0, mctx.zmode_decal ? SSDB : 0, 0);
     }
 
-    MTL::Buffer* vertex_buffer = mctx.vertex_buffer_pool[mctx.current_vertex_buffer_pool_index];
-    memcpy((char*)vertex_buffer->contents() + mctx.current_vertex_buffer_offset, buf_vbo, sizeof(float) * buf_vbo_len);
-
-    if (!current_framebuffer.has_bounded_vertex_buffer) {
-        current_framebuffer.command_encoder->setVertexBuffer(vertex_buffer, 0, 0);
-        current_framebuffer.has_bounded_vertex_buffer = true;
-    }
-
-    current_framebuffer.command_encoder->setVertexBufferOffset(mctx.current_vertex_buffer_offset, 0);
-
     if (!current_framebuffer.has_bounded_fragment_buffer) {
         current_framebuffer.command_encoder->setFragmentBuffer(mctx.frame_uniform_buffer, 0, 0);
         current_framebuffer.has_bounded_fragment_buffer = true;
@@ -643,6 +633,23 @@ static void gfx_metal_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
             mctx.shader_program->pipeline_state_variants[current_framebuffer.msaa_level];
         current_framebuffer.command_encoder->setRenderPipelineState(pipeline_state);
     }
+}
+
+static void gfx_metal_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+    NS::AutoreleasePool* autorelease_pool = NS::AutoreleasePool::alloc()->init();
+
+    auto& current_framebuffer = mctx.framebuffers[mctx.current_framebuffer];
+    gfx_metal_prepare_draw();
+
+    MTL::Buffer* vertex_buffer = mctx.vertex_buffer_pool[mctx.current_vertex_buffer_pool_index];
+    memcpy((char*)vertex_buffer->contents() + mctx.current_vertex_buffer_offset, buf_vbo, sizeof(float) * buf_vbo_len);
+
+    if (!current_framebuffer.has_bounded_vertex_buffer) {
+        current_framebuffer.command_encoder->setVertexBuffer(vertex_buffer, 0, 0);
+        current_framebuffer.has_bounded_vertex_buffer = true;
+    }
+
+    current_framebuffer.command_encoder->setVertexBufferOffset(mctx.current_vertex_buffer_offset, 0);
 
     current_framebuffer.command_encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, 0.f, buf_vbo_num_tris * 3);
     mctx.current_vertex_buffer_offset += sizeof(float) * buf_vbo_len;
@@ -650,6 +657,51 @@ static void gfx_metal_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
     autorelease_pool->release();
 }
 
+static uint32_t gfx_metal_new_vertex_buffer() {
+    if (!mctx.free_retained_vertex_buffers.empty()) {
+        uint32_t buffer_id = mctx.free_retained_vertex_buffers.back();
+        mctx.free_retained_vertex_buffers.pop_back();
+        return buffer_id;
+    }
+
+    mctx.retained_vertex_buffers.push_back(nullptr);
+    return (uint32_t)(mctx.retained_vertex_buffers.size() - 1);
+}
+
+static void gfx_metal_upload_vertex_buffer(uint32_t buffer_id, const float buf_vbo[], size_t buf_vbo_len) {
+    // Command buffers keep the buffers they use alive, so the old one can be released even if a draw that uses it
+    // is still in flight.
+    MTL::Buffer*& buffer = mctx.retained_vertex_buffers[buffer_id];
+    if (buffer != nullptr) {
+        buffer->release();
+    }
+    buffer = mctx.device->newBuffer(buf_vbo, sizeof(float) * buf_vbo_len, MTL::ResourceStorageModeShared);
+}
+
+static void gfx_metal_draw_vertex_buffer(uint32_t buffer_id, size_t buf_vbo_num_tris) {
+    NS::AutoreleasePool* autorelease_pool = NS::AutoreleasePool::alloc()->init();
+
+    auto& current_framebuffer = mctx.framebuffers[mctx.current_framebuffer];
+    gfx_metal_prepare_draw();
+
+    // Replaces the streaming buffer, which draw_triangles binds again on its next draw.
+    current_framebuffer.command_encoder->setVertexBuffer(mctx.retained_vertex_buffers[buffer_id], 0, 0);
+    current_framebuffer.has_bounded_vertex_buffer = false;
+
+    current_framebuffer.command_encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, 0.f, buf_vbo_num_tris * 3);
+
+    autorelease_pool->release();
+}
+
+static void gfx_metal_delete_vertex_buffer(uint32_t buffer_id) {
+    MTL::Buffer*& buffer = mctx.retained_vertex_buffers[buffer_id];
+    if (buffer != nullptr) {
+        buffer->release();
+        buffer = nullptr;
+    }
+    mctx.free_retained_vertex_buffers.push_back(buffer_id);
+}
+
 static void gfx_metal_on_resize() {
 }
 
@@ -1318,6 +1370,10 @@ struct GfxRenderingAPI gfx_metal_api = { gfx_metal_get_name,
                                          gfx_metal_set_scissor,
                                          gfx_metal_set_use_alpha,
                                          gfx_metal_draw_triangles,
+                                         gfx_metal_new_vertex_buffer,
+                                         gfx_metal_upload_vertex_buffer,
+                                         gfx_metal_draw_vertex_buffer,
+                                         gfx_metal_delete_vertex_buffer,
                                          gfx_metal_init,
                                          gfx_metal_on_resize,
                                          gfx_metal_start_frame,
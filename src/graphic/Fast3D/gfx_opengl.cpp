@@ -688,7 +688,7 @@ static void gfx_opengl_set_use_alpha(bool use_alpha) {
     }
 }
 
-static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+static void gfx_opengl_prepare_draw() {
     if (current_depth_test != last_depth_test || current_depth_mask != last_depth_mask) {
         last_depth_test = current_depth_test;
         last_depth_mask = current_depth_mask;
@@ -739,12 +739,46 @@ static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_
     }
 
     gfx_opengl_set_per_draw_uniforms();
+}
+
+static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+    gfx_opengl_prepare_draw();
 
     // printf("flushing %d tris\n", buf_vbo_num_tris);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * buf_vbo_len, buf_vbo, GL_STREAM_DRAW);
     glDrawArrays(GL_TRIANGLES, 0, 3 * buf_vbo_num_tris);
 }
 
+static uint32_t gfx_opengl_new_vertex_buffer() {
+    GLuint buffer_id;
+    glGenBuffers(1, &buffer_id);
+    return buffer_id;
+}
+
+static void gfx_opengl_upload_vertex_buffer(uint32_t buffer_id, const float buf_vbo[], size_t buf_vbo_len) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * buf_vbo_len, buf_vbo, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, opengl_vbo);
+}
+
+static void gfx_opengl_draw_vertex_buffer(uint32_t buffer_id, size_t buf_vbo_num_tris) {
+    gfx_opengl_prepare_draw();
+
+    // The attribute pointers refer to the buffer that was bound when they were set, so they have to be set again
+    // when switching to the retained buffer and back.
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    gfx_opengl_vertex_array_set_attribs(current_shader_program);
+    glDrawArrays(GL_TRIANGLES, 0, 3 * buf_vbo_num_tris);
+
+    glBindBuffer(GL_ARRAY_BUFFER, opengl_vbo);
+    gfx_opengl_vertex_array_set_attribs(current_shader_program);
+}
+
+static void gfx_opengl_delete_vertex_buffer(uint32_t buffer_id) {
+    GLuint id = buffer_id;
+    glDeleteBuffers(1, &id);
+}
+
 static void gfx_opengl_init() {
 #ifndef __linux__
     glewInit();
@@ -1099,6 +1133,10 @@ struct GfxRenderingAPI gfx_opengl_api = { gfx_opengl_get_name,
                                           gfx_opengl_set_scissor,
                                           gfx_opengl_set_use_alpha,
                                           gfx_opengl_draw_triangles,
+                                          gfx_opengl_new_vertex_buffer,
+                                          gfx_opengl_upload_vertex_buffer,
+                                          gfx_opengl_draw_vertex_buffer,
+                                          gfx_opengl_delete_vertex_buffer,
                                           gfx_opengl_init,
                                           gfx_opengl_on_resize,
                                           gfx_opengl_start_frame,
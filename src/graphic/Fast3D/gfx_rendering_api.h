@@ -48,6 +48,12 @@ struct GfxRenderingAPI {
     void (*set_scissor)(int x, int y, int width, int height);
     void (*set_use_alpha)(bool use_alpha);
     void (*draw_triangles)(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris);
+    // Vertex buffers that stay on the GPU between frames. The data has the same layout as for draw_triangles and is
+    // drawn with the currently loaded shader and render state.
+    uint32_t (*new_vertex_buffer)();
+    void (*upload_vertex_buffer)(uint32_t buffer_id, const float buf_vbo[], size_t buf_vbo_len);
+    void (*draw_vertex_buffer)(uint32_t buffer_id, size_t buf_vbo_num_tris);
+    void (*delete_vertex_buffer)(uint32_t buffer_id);
     void (*init)();
     void (*on_resize)();
     void (*start_frame)();
@@ -15,12 +15,15 @@
 #include <vector>
 #include <list>
 #include <stack>
+#include <algorithm>
 #include "resource/type/Light.h"
+#include "resource/type/Mesh.h"
 
 #ifndef _LANGUAGE_C
 #define _LANGUAGE_C
 #endif
 #include "graphic/Fast3D/debug/GfxDebugger.h"
+#include "graphic/Fast3D/debug/GfxProfiler.h"
 #include "libultraship/libultra/types.h"
 #include <string>
 
@@ -38,6 +41,10 @@
 
 #include <spdlog/fmt/fmt.h>
 
+#ifdef GFX_OPCODE_PROFILER
+#include <chrono>
+#endif
+
 std::stack<std::string> currentDir;
 
 #define SEG_ADDR(seg, addr) (addr | (seg << 24) | 1)
@@ -1153,11 +1160,166 @@ void Interpreter::AdjustWidthHeightForScale(uint32_t& width, uint32_t& height, u
     }
 }
 
+static inline uint64_t HashRound(uint64_t h, uint64_t v) {
+    h ^= v * 0xC2B2AE3D27D4EB4FULL;
+    h = (h << 31) | (h >> 33);
+    return h * 0x9E3779B185EBCA87ULL;
+}
+
+static uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t h = HashRound(seed, size);
+
+    for (; size >= sizeof(uint64_t); p += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        h = HashRound(h, v);
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, p, size);
+    return HashRound(h, tail);
+}
+
+void Interpreter::UpdateLightCoeffs() {
+    if (!mRsp->lights_changed) {
+        return;
+    }
+
+    for (int i = 0; i < mRsp->current_num_lights - 1; i++) {
+        CalculateNormalDir(&mRsp->current_lights[i].l, mRsp->current_lights_coeffs[i]);
+    }
+    /*static const Light_t lookat_x = {{0, 0, 0}, 0, {0, 0, 0}, 0, {127, 0, 0}, 0};
+    static const Light_t lookat_y = {{0, 0, 0}, 0, {0, 0, 0}, 0, {0, 127, 0}, 0};*/
+    CalculateNormalDir(&mRsp->lookat[0], mRsp->current_lookat_coeffs[0]);
+    CalculateNormalDir(&mRsp->lookat[1], mRsp->current_lookat_coeffs[1]);
+    mRsp->lights_changed = false;
+}
+
+void Interpreter::VertexCacheClear() {
+    mVertexCache.map.clear();
+    mVertexCache.lru.clear();
+    mVertexCache.used_bytes = 0;
+}
+
+void Interpreter::SetVertexCacheBudget(size_t bytes) {
+    if (bytes == mVertexCache.budget_bytes) {
+        return;
+    }
+
+    mVertexCache.budget_bytes = bytes;
+    while (mVertexCache.used_bytes > mVertexCache.budget_bytes && !mVertexCache.lru.empty()) {
+        auto it = mVertexCache.map.find(mVertexCache.lru.front());
+        mVertexCache.used_bytes -= it->second.vertices.size() * sizeof(LoadedVertex);
+        mVertexCache.map.erase(it);
+        mVertexCache.lru.pop_front();
+        mVertexCache.evictions++;
+    }
+}
+
+// Hashes all RSP state that TransformVertices reads besides the vertices themselves.
+// Must be called after UpdateLightCoeffs so the light coefficients are current.
+uint64_t Interpreter::VertexCacheStateHash() const {
+    constexpr uint32_t vertexGeometryModes =
+        G_LIGHTING | G_TEXTURE_GEN | G_TEXTURE_GEN_LINEAR | G_FOG | G_LIGHTING_POSITIONAL;
+    const uint32_t geometryMode = mRsp->geometry_mode & vertexGeometryModes;
+    const float aspectAdjust = AdjXForAspectRatio(1.0f);
+
+    uint64_t h = HashBytes(mRsp->MP_matrix, sizeof(mRsp->MP_matrix), geometryMode);
+    h = HashBytes(&mRsp->texture_scaling_factor, sizeof(mRsp->texture_scaling_factor), h);
+    h = HashBytes(&aspectAdjust, sizeof(aspectAdjust), h);
+
+    if (geometryMode & G_FOG) {
+        h = HashRound(h, ((uint64_t)(uint16_t)mRsp->fog_mul << 16) | (uint16_t)mRsp->fog_offset);
+    }
+
+    if (geometryMode & G_LIGHTING) {
+        h = HashRound(h, mRsp->current_num_lights);
+        h = HashBytes(mRsp->current_lights, sizeof(F3DLight) * mRsp->current_num_lights, h);
+        // current_num_lights includes the ambient light, which has no coefficients
+        const size_t numCoeffs = mRsp->current_num_lights > 0 ? mRsp->current_num_lights - 1 : 0;
+        h = HashBytes(mRsp->current_lights_coeffs, sizeof(mRsp->current_lights_coeffs[0]) * numCoeffs, h);
+        h = HashBytes(mRsp->current_lookat_coeffs, sizeof(mRsp->current_lookat_coeffs), h);
+
+        if (geometryMode & G_LIGHTING_POSITIONAL) {
+            h = HashBytes(mRsp->modelview_matrix_stack[mRsp->modelview_matrix_stack_size - 1],
+                          sizeof(mRsp->modelview_matrix_stack[0]), h);
+        }
+    }
+
+    return h;
+}
+
+bool Interpreter::VertexCacheLookup(const VertexCacheKey& key, uint64_t dataHash, size_t destIndex) {
+    auto it = mVertexCache.map.find(key);
+    if (it == mVertexCache.map.end() || it->second.data_hash != dataHash) {
+        mVertexCache.misses++;
+        return false;
+    }
+
+    memcpy(&mRsp->loaded_vertices[destIndex], it->second.vertices.data(), key.count * sizeof(LoadedVertex));
+    mVertexCache.lru.splice(mVertexCache.lru.end(), mVertexCache.lru, it->second.lru_location); // move to back
+    mVertexCache.hits++;
+    return true;
+}
+
+void Interpreter::VertexCacheInsert(const VertexCacheKey& key, uint64_t dataHash, size_t destIndex) {
+    const size_t bytes = key.count * sizeof(LoadedVertex);
+    if (bytes > mVertexCache.budget_bytes) {
+        return;
+    }
+
+    auto it = mVertexCache.map.find(key);
+    if (it != mVertexCache.map.end()) {
+        // Same pointer with different contents, refresh the entry in place
+        it->second.data_hash = dataHash;
+        memcpy(it->second.vertices.data(), &mRsp->loaded_vertices[destIndex], bytes);
+        mVertexCache.lru.splice(mVertexCache.lru.end(), mVertexCache.lru, it->second.lru_location);
+        return;
+    }
+
+    while (mVertexCache.used_bytes + bytes > mVertexCache.budget_bytes && !mVertexCache.lru.empty()) {
+        // Remove the entry that was least recently used
+        auto lruIt = mVertexCache.map.find(mVertexCache.lru.front());
+        mVertexCache.used_bytes -= lruIt->second.vertices.size() * sizeof(LoadedVertex);
+        mVertexCache.map.erase(lruIt);
+        mVertexCache.lru.pop_front();
+        mVertexCache.evictions++;
+    }
+
+    VertexCacheValue& value = mVertexCache.map[key];
+    value.data_hash = dataHash;
+    value.vertices.assign(&mRsp->loaded_vertices[destIndex], &mRsp->loaded_vertices[destIndex + key.count]);
+    value.lru_location = mVertexCache.lru.insert(mVertexCache.lru.end(), key);
+    mVertexCache.used_bytes += bytes;
+}
+
 void Interpreter::GfxSpVertex(size_t n_vertices, size_t dest_index, const F3DVtx* vertices) {
-    for (size_t i = 0; i < n_vertices; i++, dest_index++) {
+    if (mVertexCache.budget_bytes == 0 || vertices == nullptr || n_vertices == 0) {
+        TransformVertices(n_vertices, &mRsp->loaded_vertices[dest_index], vertices);
+        return;
+    }
+
+    if (mRsp->geometry_mode & G_LIGHTING) {
+        UpdateLightCoeffs();
+    }
+
+    const VertexCacheKey key = { vertices, (uint32_t)n_vertices, VertexCacheStateHash() };
+    const uint64_t dataHash = HashBytes(vertices, n_vertices * sizeof(F3DVtx), 0);
+
+    if (VertexCacheLookup(key, dataHash, dest_index)) {
+        return;
+    }
+
+    TransformVertices(n_vertices, &mRsp->loaded_vertices[dest_index], vertices);
+    VertexCacheInsert(key, dataHash, dest_index);
+}
+
+void Interpreter::TransformVertices(size_t n_vertices, LoadedVertex* dest, const F3DVtx* vertices) {
+    for (size_t i = 0; i < n_vertices; i++) {
         const F3DVtx_t* v = &vertices[i].v;
         const F3DVtx_tn* vn = &vertices[i].n;
-        struct LoadedVertex* d = &mRsp->loaded_vertices[dest_index];
+        struct LoadedVertex* d = &dest[i];
 
         if (v == nullptr) {
             return;
@@ -1186,16 +1348,7 @@ void Interpreter::GfxSpVertex(size_t n_vertices, size_t dest_index, const F3DVtx
         short V = v->tc[1] * mRsp->texture_scaling_factor.t >> 16;
 
         if (mRsp->geometry_mode & G_LIGHTING) {
-            if (mRsp->lights_changed) {
-                for (int i = 0; i < mRsp->current_num_lights - 1; i++) {
-                    CalculateNormalDir(&mRsp->current_lights[i].l, mRsp->current_lights_coeffs[i]);
-                }
-                /*static const Light_t lookat_x = {{0, 0, 0}, 0, {0, 0, 0}, 0, {127, 0, 0}, 0};
-                static const Light_t lookat_y = {{0, 0, 0}, 0, {0, 0, 0}, 0, {0, 127, 0}, 0};*/
-                CalculateNormalDir(&mRsp->lookat[0], mRsp->current_lookat_coeffs[0]);
-                CalculateNormalDir(&mRsp->lookat[1], mRsp->current_lookat_coeffs[1]);
-                mRsp->lights_changed = false;
-            }
+            UpdateLightCoeffs();
 
             int r = mRsp->current_lights[mRsp->current_num_lights - 1].l.col[0];
             int g = mRsp->current_lights[mRsp->current_num_lights - 1].l.col[1];
@@ -1353,16 +1506,206 @@ void Interpreter::GfxSpModifyVertex(uint16_t vtx_idx, uint8_t where, uint32_t va
 }
 
 void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx, bool is_rect) {
-    struct LoadedVertex* v1 = &mRsp->loaded_vertices[vtx1_idx];
-    struct LoadedVertex* v2 = &mRsp->loaded_vertices[vtx2_idx];
-    struct LoadedVertex* v3 = &mRsp->loaded_vertices[vtx3_idx];
-    struct LoadedVertex* v_arr[3] = { v1, v2, v3 };
+    GfxSpTri(&mRsp->loaded_vertices[vtx1_idx], &mRsp->loaded_vertices[vtx2_idx], &mRsp->loaded_vertices[vtx3_idx],
+             is_rect);
+}
 
-    // if (rand()%2) return;
+void Interpreter::GfxSpVertexExt(size_t n_vertices, size_t dest_index, const F3DVtx* vertices) {
+    if (vertices == nullptr || n_vertices == 0) {
+        return;
+    }
+
+    if (dest_index + n_vertices > MAX_EXT_VERTICES) {
+        SPDLOG_ERROR("G_VTX_EXT: Loading {} vertices at {} overflows the {} entry vertex arena", n_vertices,
+                     dest_index, MAX_EXT_VERTICES);
+        return;
+    }
+
+    // The arena only grows, so a steady state frame never reallocates it.
+    if (mVertexArena.size() < dest_index + n_vertices) {
+        mVertexArena.resize(dest_index + n_vertices);
+        mVertexArenaLoads.resize(dest_index + n_vertices, 0);
+    }
+
+    TransformVertices(n_vertices, &mVertexArena[dest_index], vertices);
+    std::fill_n(&mVertexArenaLoads[dest_index], n_vertices, mVertexArenaFrame);
+}
+
+void Interpreter::GfxSpTriIndexed(const uint16_t* indices, size_t num_indices) {
+    if (indices == nullptr) {
+        return;
+    }
+
+    LoadedVertex* arena = mVertexArena.data();
+    const uint32_t* loads = mVertexArenaLoads.data();
+    const size_t arena_size = mVertexArena.size();
+    const uint32_t frame = mVertexArenaFrame;
+
+    for (size_t i = 0; i + 2 < num_indices; i += 3) {
+        const uint16_t i0 = indices[i + 0];
+        const uint16_t i1 = indices[i + 1];
+        const uint16_t i2 = indices[i + 2];
+
+        // Entries that weren't loaded during this frame still hold vertices from an earlier one.
+        if (i0 >= arena_size || i1 >= arena_size || i2 >= arena_size || loads[i0] != frame || loads[i1] != frame ||
+            loads[i2] != frame) {
+            continue;
+        }
+
+        GfxSpTri(&arena[i0], &arena[i1], &arena[i2], false);
+    }
+}
+
+// Hashes everything the triangles of a mesh are built from besides its vertices: the vertex transform, culling, and
+// the RDP state EmitTriangle reads. Must be called after PrepareTriangleState and UpdateLightCoeffs.
+uint64_t Interpreter::MeshBufferStateHash(const TriangleDrawState& state) const {
+    uint64_t h = HashRound(VertexCacheStateHash(), (uintptr_t)state.comb);
+    h = HashRound(h, state.tm | (uint64_t)state.num_inputs << 16 | (uint64_t)state.used_textures[0] << 24 |
+                         (uint64_t)state.used_textures[1] << 25 | (uint64_t)state.use_alpha << 26 |
+                         (uint64_t)state.use_fog << 27 | (uint64_t)state.use_grayscale << 28 |
+                         (uint64_t)state.clip_parameters.z_is_from_0_to_1 << 29 |
+                         (uint64_t)state.clip_parameters.invert_y << 30);
+
+    for (int t = 0; t < 2; t++) {
+        if (!state.used_textures[t]) {
+            continue;
+        }
+
+        const auto& tile = mRdp->texture_tile[mRdp->first_tile_index + t];
+        h = HashRound(h, state.tex_width[t] | (uint64_t)state.tex_height[t] << 32);
+        h = HashRound(h, state.tex_width2[t] | (uint64_t)state.tex_height2[t] << 32);
+        h = HashRound(h, tile.shifts | tile.shiftt << 8);
+        h = HashBytes(&tile.uls, sizeof(tile.uls), h);
+        h = HashBytes(&tile.ult, sizeof(tile.ult), h);
+    }
+
+    h = HashRound(h, mRdp->other_mode_l | (uint64_t)mRdp->other_mode_h << 32);
+    h = HashRound(h, mRsp->geometry_mode | (uint64_t)mRsp->extra_geometry_mode << 32);
+    h = HashRound(h, ucode_handler_index | mRdp->prim_lod_fraction << 8);
+
+    const RGBA colors[] = { mRdp->prim_color, mRdp->env_color, mRdp->fog_color, mRdp->grayscale_color };
+    return HashBytes(colors, sizeof(colors), h);
+}
+
+void Interpreter::GfxSpMesh(const std::shared_ptr<Mesh>& mesh) {
+    const size_t num_vertices = mesh->GetVertexCount();
+    const size_t num_indices = mesh->IndexList.size();
+    if (num_vertices == 0 || num_indices < 3) {
+        return;
+    }
+
+    if (mRsp->geometry_mode & G_LIGHTING) {
+        UpdateLightCoeffs();
+    }
+
+    // A mesh is drawn with a single state, so it is applied once for the whole mesh.
+    TriangleDrawState state;
+    PrepareTriangleState(state);
+
+    // A mesh drawn with the same matrices, lights and RDP state on two consecutive frames is built once and kept on
+    // the GPU until that changes. Everything else, e.g. a mesh under a moving camera, is streamed like any other
+    // triangles, so a miss costs no more than drawing the mesh through the RSP would.
+    const MeshBufferKey key = { mesh.get(), MeshBufferStateHash(state) };
+    auto [it, inserted] = mMeshBuffers.try_emplace(key);
+    MeshBuffer& buffer = it->second;
+    if (!inserted && buffer.mesh.lock() != mesh) {
+        // Left behind by a freed mesh that was allocated at the same address.
+        if (buffer.retained && buffer.num_tris > 0) {
+            mRapi->delete_vertex_buffer(buffer.buffer_id);
+        }
+        buffer = {};
+        inserted = true;
+    }
+    const bool seen_last_frame = !inserted && buffer.frame + 1 == mMeshFrame;
+    buffer.mesh = mesh;
+    buffer.frame = mMeshFrame;
+
+    if (!buffer.retained) {
+        // Meshes are not bound by the RSP vertex buffer, so they are transformed in a single batch and then built
+        // straight from it. The indices were checked against the vertex count when the mesh was loaded.
+        if (mMeshVertices.size() < num_vertices) {
+            mMeshVertices.resize(num_vertices);
+        }
+        LoadedVertex* vertices = mMeshVertices.data();
+        TransformVertices(num_vertices, vertices, (const F3DVtx*)mesh->GetPointer());
+        const uint16_t* indices = mesh->IndexList.data();
+
+        if (!seen_last_frame) {
+            for (size_t i = 0; i + 2 < num_indices; i += 3) {
+                LoadedVertex* v1 = &vertices[indices[i + 0]];
+                LoadedVertex* v2 = &vertices[indices[i + 1]];
+                LoadedVertex* v3 = &vertices[indices[i + 2]];
+                if (CullTriangle(v1, v2, v3)) {
+                    continue;
+                }
+
+                mBufVboLen += EmitTriangle(&mBufVbo[mBufVboLen], state, v1, v2, v3, false);
+                if (++mBufVboNumTris == MAX_TRI_BUFFER) {
+                    Flush();
+                }
+            }
+            return;
+        }
+
+        if (mMeshVbo.size() < num_indices * 32) {
+            mMeshVbo.resize(num_indices * 32);
+        }
+        size_t len = 0;
+        for (size_t i = 0; i + 2 < num_indices; i += 3) {
+            LoadedVertex* v1 = &vertices[indices[i + 0]];
+            LoadedVertex* v2 = &vertices[indices[i + 1]];
+            LoadedVertex* v3 = &vertices[indices[i + 2]];
+            if (CullTriangle(v1, v2, v3)) {
+                continue;
+            }
+
+            len += EmitTriangle(&mMeshVbo[len], state, v1, v2, v3, false);
+            buffer.num_tris++;
+        }
+
+        if (buffer.num_tris > 0) {
+            buffer.buffer_id = mRapi->new_vertex_buffer();
+            mRapi->upload_vertex_buffer(buffer.buffer_id, mMeshVbo.data(), len);
+        }
+        buffer.retained = true;
+    }
+
+    if (buffer.num_tris > 0) {
+        // Triangles queued before the mesh have to be drawn first.
+        Flush();
+        mRapi->draw_vertex_buffer(buffer.buffer_id, buffer.num_tris);
+    }
+}
+
+// Forgets the meshes that weren't drawn since the last call, freeing their buffers.
+void Interpreter::SweepMeshBuffers() {
+    for (auto it = mMeshBuffers.begin(); it != mMeshBuffers.end();) {
+        if (it->second.frame == mMeshFrame) {
+            ++it;
+            continue;
+        }
+
+        if (it->second.retained && it->second.num_tris > 0) {
+            mRapi->delete_vertex_buffer(it->second.buffer_id);
+        }
+        it = mMeshBuffers.erase(it);
+    }
+    mMeshFrame++;
+}
+
+void Interpreter::MeshBuffersClear() {
+    for (auto& [key, buffer] : mMeshBuffers) {
+        if (buffer.retained && buffer.num_tris > 0) {
+            mRapi->delete_vertex_buffer(buffer.buffer_id);
+        }
+    }
+    mMeshBuffers.clear();
+}
 
+bool Interpreter::CullTriangle(const LoadedVertex* v1, const LoadedVertex* v2, const LoadedVertex* v3) const {
     if (v1->clip_rej & v2->clip_rej & v3->clip_rej) {
         // The whole triangle lies outside the visible area
-        return;
+        return true;
     }
 
     const uint32_t cull_both = get_attr(CULL_BOTH);
@@ -1392,18 +1735,24 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
 
         if (cull_type == cull_front) {
             if (cross <= 0) {
-                return;
+                return true;
             }
         } else if (cull_type == cull_back) {
             if (cross >= 0) {
-                return;
+                return true;
             }
         } else if (cull_type == cull_both) {
             // Why is this even an option?
-            return;
+            return true;
         }
     }
 
+    return false;
+}
+
+// Applies the render state for drawing triangles, flushing what was drawn with the previous state, and returns
+// what EmitTriangle needs to build their vertices.
+void Interpreter::PrepareTriangleState(TriangleDrawState& state) {
     bool depth_test = (mRsp->geometry_mode & G_ZBUFFER) == G_ZBUFFER;
     bool depth_mask = (mRdp->other_mode_l & Z_UPD) == Z_UPD;
     uint8_t depth_test_and_mask = (depth_test ? 1 : 0) | (depth_mask ? 2 : 0);
@@ -1511,7 +1860,6 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
     ColorCombiner* comb = LookupOrCreateColorCombiner(key);
 
     uint32_t tm = 0;
-    uint32_t tex_width[2], tex_height[2], tex_width2[2], tex_height2[2];
 
     for (int i = 0; i < 2; i++) {
         uint32_t tile = mRdp->first_tile_index + i;
@@ -1538,7 +1886,7 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
                 line_size = 1;
             }
 
-            tex_height[i] = tex_size_bytes / line_size;
+            state.tex_height[i] = tex_size_bytes / line_size;
             switch (mRdp->texture_tile[tile].siz) {
                 case G_IM_SIZ_4b:
                     line_size <<= 1;
@@ -1550,22 +1898,22 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
                     break;
                 case G_IM_SIZ_32b:
                     line_size /= G_IM_SIZ_32b_LINE_BYTES; // this is 2!
-                    tex_height[i] /= 2;
+                    state.tex_height[i] /= 2;
                     break;
             }
-            tex_width[i] = line_size;
+            state.tex_width[i] = line_size;
 
-            tex_width2[i] = (mRdp->texture_tile[tile].lrs - mRdp->texture_tile[tile].uls + 4) / 4;
-            tex_height2[i] = (mRdp->texture_tile[tile].lrt - mRdp->texture_tile[tile].ult + 4) / 4;
+            state.tex_width2[i] = (mRdp->texture_tile[tile].lrs - mRdp->texture_tile[tile].uls + 4) / 4;
+            state.tex_height2[i] = (mRdp->texture_tile[tile].lrt - mRdp->texture_tile[tile].ult + 4) / 4;
 
-            uint32_t tex_width1 = tex_width[i] << (cms & G_TX_MIRROR);
-            uint32_t tex_height1 = tex_height[i] << (cmt & G_TX_MIRROR);
+            uint32_t tex_width1 = state.tex_width[i] << (cms & G_TX_MIRROR);
+            uint32_t tex_height1 = state.tex_height[i] << (cmt & G_TX_MIRROR);
 
-            if ((cms & G_TX_CLAMP) && ((cms & G_TX_MIRROR) || tex_width1 != tex_width2[i])) {
+            if ((cms & G_TX_CLAMP) && ((cms & G_TX_MIRROR) || tex_width1 != state.tex_width2[i])) {
                 tm |= 1 << 2 * i;
                 cms &= ~G_TX_CLAMP;
             }
-            if ((cmt & G_TX_CLAMP) && ((cmt & G_TX_MIRROR) || tex_height1 != tex_height2[i])) {
+            if ((cmt & G_TX_CLAMP) && ((cmt & G_TX_MIRROR) || tex_height1 != state.tex_height2[i])) {
                 tm |= 1 << 2 * i + 1;
                 cmt &= ~G_TX_CLAMP;
             }
@@ -1608,26 +1956,36 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
         mRapi->set_use_alpha(use_alpha);
         mRenderingState.alpha_blend = use_alpha;
     }
-    uint8_t num_inputs;
-    bool used_textures[2];
 
-    mRapi->shader_get_info(prg, &num_inputs, used_textures);
+    mRapi->shader_get_info(prg, &state.num_inputs, state.used_textures);
+
+    state.comb = comb;
+    state.tm = tm;
+    state.use_alpha = use_alpha;
+    state.use_fog = use_fog;
+    state.use_grayscale = use_grayscale;
+    state.clip_parameters = mRapi->get_clip_parameters();
+}
 
-    struct GfxClipParameters clip_parameters = mRapi->get_clip_parameters();
+// Writes the vertices of one triangle in the layout of the loaded shader and returns the number of floats written.
+size_t Interpreter::EmitTriangle(float* buf, const TriangleDrawState& state, LoadedVertex* v1, LoadedVertex* v2,
+                                 LoadedVertex* v3, bool is_rect) {
+    struct LoadedVertex* v_arr[3] = { v1, v2, v3 };
+    size_t len = 0;
 
     for (int i = 0; i < 3; i++) {
         float z = v_arr[i]->z, w = v_arr[i]->w;
-        if (clip_parameters.z_is_from_0_to_1) {
+        if (state.clip_parameters.z_is_from_0_to_1) {
             z = (z + w) / 2.0f;
         }
 
-        mBufVbo[mBufVboLen++] = v_arr[i]->x;
-        mBufVbo[mBufVboLen++] = clip_parameters.invert_y ? -v_arr[i]->y : v_arr[i]->y;
-        mBufVbo[mBufVboLen++] = z;
-        mBufVbo[mBufVboLen++] = w;
+        buf[len++] = v_arr[i]->x;
+        buf[len++] = state.clip_parameters.invert_y ? -v_arr[i]->y : v_arr[i]->y;
+        buf[len++] = z;
+        buf[len++] = w;
 
         for (int t = 0; t < 2; t++) {
-            if (!used_textures[t]) {
+            if (!state.used_textures[t]) {
                 continue;
             }
             float u = v_arr[i]->u / 32.0f;
@@ -1661,40 +2019,40 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
                 }
             }
 
-            mBufVbo[mBufVboLen++] = u / tex_width[t];
-            mBufVbo[mBufVboLen++] = v / tex_height[t];
+            buf[len++] = u / state.tex_width[t];
+            buf[len++] = v / state.tex_height[t];
 
-            bool clampS = tm & (1 << 2 * t);
-            bool clampT = tm & (1 << 2 * t + 1);
+            bool clampS = state.tm & (1 << 2 * t);
+            bool clampT = state.tm & (1 << 2 * t + 1);
 
             if (clampS) {
-                mBufVbo[mBufVboLen++] = (tex_width2[t] - 0.5f) / tex_width[t];
+                buf[len++] = (state.tex_width2[t] - 0.5f) / state.tex_width[t];
             }
 
             if (clampT) {
-                mBufVbo[mBufVboLen++] = (tex_height2[t] - 0.5f) / tex_height[t];
+                buf[len++] = (state.tex_height2[t] - 0.5f) / state.tex_height[t];
             }
         }
 
-        if (use_fog) {
-            mBufVbo[mBufVboLen++] = mRdp->fog_color.r / 255.0f;
-            mBufVbo[mBufVboLen++] = mRdp->fog_color.g / 255.0f;
-            mBufVbo[mBufVboLen++] = mRdp->fog_color.b / 255.0f;
-            mBufVbo[mBufVboLen++] = v_arr[i]->color.a / 255.0f; // fog factor (not alpha)
+        if (state.use_fog) {
+            buf[len++] = mRdp->fog_color.r / 255.0f;
+            buf[len++] = mRdp->fog_color.g / 255.0f;
+            buf[len++] = mRdp->fog_color.b / 255.0f;
+            buf[len++] = v_arr[i]->color.a / 255.0f; // fog factor (not alpha)
         }
 
-        if (use_grayscale) {
-            mBufVbo[mBufVboLen++] = mRdp->grayscale_color.r / 255.0f;
-            mBufVbo[mBufVboLen++] = mRdp->grayscale_color.g / 255.0f;
-            mBufVbo[mBufVboLen++] = mRdp->grayscale_color.b / 255.0f;
-            mBufVbo[mBufVboLen++] = mRdp->grayscale_color.a / 255.0f; // lerp interpolation factor (not alpha)
+        if (state.use_grayscale) {
+            buf[len++] = mRdp->grayscale_color.r / 255.0f;
+            buf[len++] = mRdp->grayscale_color.g / 255.0f;
+            buf[len++] = mRdp->grayscale_color.b / 255.0f;
+            buf[len++] = mRdp->grayscale_color.a / 255.0f; // lerp interpolation factor (not alpha)
         }
 
-        for (int j = 0; j < num_inputs; j++) {
+        for (int j = 0; j < state.num_inputs; j++) {
             RGBA* color;
             RGBA tmp;
-            for (int k = 0; k < 1 + (use_alpha ? 1 : 0); k++) {
-                switch (comb->shader_input_mapping[k][j]) {
+            for (int k = 0; k < 1 + (state.use_alpha ? 1 : 0); k++) {
+                switch (state.comb->shader_input_mapping[k][j]) {
                         // Note: CCMUX constants and ACMUX constants used here have same value, which is why this works
                         // (except LOD fraction).
                     case G_CCMUX_PRIMITIVE:
@@ -1748,27 +2106,41 @@ void Interpreter::GfxSpTri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx
                         break;
                 }
                 if (k == 0) {
-                    mBufVbo[mBufVboLen++] = color->r / 255.0f;
-                    mBufVbo[mBufVboLen++] = color->g / 255.0f;
-                    mBufVbo[mBufVboLen++] = color->b / 255.0f;
+                    buf[len++] = color->r / 255.0f;
+                    buf[len++] = color->g / 255.0f;
+                    buf[len++] = color->b / 255.0f;
                 } else {
-                    if (use_fog && color == &v_arr[i]->color) {
+                    if (state.use_fog && color == &v_arr[i]->color) {
                         // Shade alpha is 100% for fog
-                        mBufVbo[mBufVboLen++] = 1.0f;
+                        buf[len++] = 1.0f;
                     } else {
-                        mBufVbo[mBufVboLen++] = color->a / 255.0f;
+                        buf[len++] = color->a / 255.0f;
                     }
                 }
             }
         }
 
         // struct RGBA *color = &v_arr[i]->color;
-        // mBufVbo[mBufVboLen++] = color->r / 255.0f;
-        // mBufVbo[mBufVboLen++] = color->g / 255.0f;
-        // mBufVbo[mBufVboLen++] = color->b / 255.0f;
-        // mBufVbo[mBufVboLen++] = color->a / 255.0f;
+        // buf[len++] = color->r / 255.0f;
+        // buf[len++] = color->g / 255.0f;
+        // buf[len++] = color->b / 255.0f;
+        // buf[len++] = color->a / 255.0f;
     }
 
+    return len;
+}
+
+void Interpreter::GfxSpTri(LoadedVertex* v1, LoadedVertex* v2, LoadedVertex* v3, bool is_rect) {
+    // if (rand()%2) return;
+
+    if (CullTriangle(v1, v2, v3)) {
+        return;
+    }
+
+    TriangleDrawState state;
+    PrepareTriangleState(state);
+    mBufVboLen += EmitTriangle(&mBufVbo[mBufVboLen], state, v1, v2, v3, is_rect);
+
     if (++mBufVboNumTris == MAX_TRI_BUFFER) {
         // if (++mBufVbo_num_tris == 1) {
         Flush();
@@ -2903,7 +3275,7 @@ int16_t Interpreter::CreateShader(const std::string& path) {
     if (shader == nullptr || !shader->IsLoaded) {
         return -1;
     }
-    shader_ids.push_back(std::string(shader->Buffer->data()));
+    shader_ids.push_back(std::string(shader->GetData(), strnlen(shader->GetData(), shader->GetDataSize())));
     return shader_ids.size() - 1;
 }
 
@@ -3039,6 +3411,52 @@ bool gfx_vtx_otr_filepath_handler_custom(F3DGfx** cmd0) {
     return false;
 }
 
+static void gfx_draw_mesh(const std::shared_ptr<Fast::Mesh>& mesh) {
+    if (mesh == nullptr) {
+        return;
+    }
+
+    Interpreter* gfx = mInstance.lock().get();
+    gfx->GfxSpMesh(mesh);
+}
+
+bool gfx_mesh_otr_hash_handler_custom(F3DGfx** cmd0) {
+    // This is a two-part display list command, the CRC64 hash of the mesh is in the second half
+    (*cmd0)++;
+    const uint64_t hash = ((uint64_t)(*cmd0)->words.w0 << 32) + (*cmd0)->words.w1;
+
+    gfx_draw_mesh(ResourceLoad<Fast::Mesh>(hash));
+    return false;
+}
+
+bool gfx_mesh_otr_filepath_handler_custom(F3DGfx** cmd0) {
+    F3DGfx* cmd = *cmd0;
+    const char* fileName = (const char*)cmd->words.w1;
+
+    gfx_draw_mesh(ResourceLoad<Fast::Mesh>(fileName));
+    return false;
+}
+
+bool gfx_vtx_ext_handler_custom(F3DGfx** cmd0) {
+    Interpreter* gfx = mInstance.lock().get();
+    const F3DVtx* vtx = (const F3DVtx*)gfx->SegAddr((*cmd0)->words.w1);
+    // This is a two-part display list command, the vertex count and destination index are in the second half
+    (*cmd0)++;
+    const size_t vtxCnt = (*cmd0)->words.w0;
+    const size_t vtxIdxOff = (*cmd0)->words.w1;
+
+    gfx->GfxSpVertexExt(vtxCnt, vtxIdxOff, vtx);
+    return false;
+}
+
+bool gfx_tri_indexed_handler_custom(F3DGfx** cmd0) {
+    Interpreter* gfx = mInstance.lock().get();
+    F3DGfx* cmd = *cmd0;
+
+    gfx->GfxSpTriIndexed((const uint16_t*)gfx->SegAddr(cmd->words.w1), C0(0, 24));
+    return false;
+}
+
 bool gfx_dl_otr_filepath_handler_custom(F3DGfx** cmd0) {
     F3DGfx* cmd = *cmd0;
     char* fileName = (char*)cmd->words.w1;
@@ -3968,6 +4386,11 @@ static constexpr UcodeHandler otrHandlers = {
     { OTR_G_SETINTENSITY, { "G_SETINTENSITY", gfx_set_intensity_handler_custom } }, // G_SETINTENSITY (0x40)
     { OTR_G_MOVEMEM_HASH, { "OTR_G_MOVEMEM_HASH", gfx_movemem_handler_otr } },      // OTR_G_MOVEMEM_HASH
     { OTR_G_LOAD_SHADER, { "G_LOAD_SHADER", gfx_set_shader_custom } },
+    { OTR_G_MESH_OTR_HASH, { "G_MESH_OTR_HASH", gfx_mesh_otr_hash_handler_custom } }, // G_MESH_OTR_HASH (0x46)
+    { OTR_G_MESH_OTR_FILEPATH,
+      { "G_MESH_OTR_FILEPATH", gfx_mesh_otr_filepath_handler_custom } }, // G_MESH_OTR_FILEPATH (0x47)
+    { OTR_G_VTX_EXT, { "G_VTX_EXT", gfx_vtx_ext_handler_custom } },             // G_VTX_EXT (0x48)
+    { OTR_G_TRI_INDEXED, { "G_TRI_INDEXED", gfx_tri_indexed_handler_custom } }, // G_TRI_INDEXED (0x49)
 };
 
 static constexpr UcodeHandler f3dex2Handlers = {
@@ -4057,6 +4480,26 @@ static constexpr std::array ucode_handlers = {
     &s2dexHandlers,  // ucode_s2dex
 };
 
+const char* GfxGetOpcodeNameForUcode(UcodeHandlers ucode, int8_t opcode) {
+    if (otrHandlers.contains(opcode)) {
+        return otrHandlers.at(opcode).first;
+    }
+
+    if (rdpHandlers.contains(opcode)) {
+        return rdpHandlers.at(opcode).first;
+    }
+
+    if (opcode == F3DEX2_G_LOAD_UCODE) {
+        return "G_LOAD_UCODE";
+    }
+
+    if (ucode < ucode_handlers.size() && ucode_handlers[ucode]->contains(opcode)) {
+        return ucode_handlers[ucode]->at(opcode).first;
+    }
+
+    return nullptr;
+}
+
 const char* GfxGetOpcodeName(int8_t opcode) {
     if (otrHandlers.contains(opcode)) {
         return otrHandlers.at(opcode).first;
@@ -4164,6 +4607,12 @@ void Interpreter::SpReset() {
     mRsp->lookat[1].dir[2] = 0;
     CalculateNormalDir(&mRsp->lookat[0], mRsp->current_lookat_coeffs[0]);
     CalculateNormalDir(&mRsp->lookat[1], mRsp->current_lookat_coeffs[1]);
+
+    // Vertex arena entries from the previous frame can't be drawn anymore.
+    if (++mVertexArenaFrame == 0) {
+        std::fill(mVertexArenaLoads.begin(), mVertexArenaLoads.end(), 0);
+        mVertexArenaFrame = 1;
+    }
 }
 
 void Interpreter::GetDimensions(uint32_t* width, uint32_t* height, int32_t* posX, int32_t* posY) {
@@ -4205,10 +4654,12 @@ void Interpreter::Init(struct GfxWindowManagerAPI* wapi, struct GfxRenderingAPI*
 void Interpreter::Destroy() {
     // TODO: should also destroy rapi, and any other resources acquired in fast3d
     free(mTexUploadBuffer);
+    MeshBuffersClear();
     mWapi->destroy();
 
     // Texture cache and loaded textures store references to Resources which need to be unreferenced.
     TextureCacheClear();
+    VertexCacheClear();
     mRdp->texture_to_load.raw_tex_metadata.resource = nullptr;
     mRdp->loaded_texture[0].raw_tex_metadata.resource = nullptr;
     mRdp->loaded_texture[1].raw_tex_metadata.resource = nullptr;
@@ -4266,6 +4717,8 @@ void Interpreter::StartFrame() {
         }
     }
 
+    SetVertexCacheBudget((size_t)std::max(CVarGetInteger(CVAR_VERTEX_CACHE_BUDGET, 0), 0) * 1024);
+
     mPrvDimensions = mCurDimensions;
     mPrevNativeDimensions = mNativeDimensions;
     if (!ViewportMatchesRendererResolution() || mMsaaLevel > 1) {
@@ -4311,6 +4764,10 @@ void Interpreter::Run(Gfx* commands, const std::unordered_map<Mtx*, MtxF>& mtx_r
     mRenderingState.viewport = {};
     mRenderingState.scissor = {};
 
+#ifdef GFX_OPCODE_PROFILER
+    mProfiler.BeginFrame();
+#endif
+
     auto dbg = Ship::Context::GetInstance()->GetGfxDebugger();
     g_exec_stack.start((F3DGfx*)commands);
     while (!g_exec_stack.cmd_stack.empty()) {
@@ -4330,10 +4787,23 @@ void Interpreter::Run(Gfx* commands, const std::unordered_map<Mtx*, MtxF>& mtx_r
             }
             g_exec_stack.gfx_path.pop_back();
         }
+#ifdef GFX_OPCODE_PROFILER
+        const UcodeHandlers ucode = ucode_handler_index;
+        const int8_t opcode = (int8_t)(cmd->words.w0 >> 24);
+        const auto start = std::chrono::steady_clock::now();
+        gfx_step();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        mProfiler.Record(ucode, opcode, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+#else
         gfx_step();
+#endif
     }
 
     Flush();
+    SweepMeshBuffers();
+#ifdef GFX_OPCODE_PROFILER
+    mProfiler.EndFrame();
+#endif
     mGfxFrameBuffer = 0;
     currentDir = std::stack<std::string>();
 
@@ -9,12 +9,14 @@
 #include <vector>
 #include <stack>
 #include <string>
+#include <memory>
 
 #include "graphic/Fast3D/lus_gbi.h"
 #include "libultraship/libultra/types.h"
 #include "public/bridge/gfxbridge.h"
 #include "gfx_cc.h"
 #include "gfx_rendering_api.h"
+#include "debug/GfxProfiler.h"
 
 #include "resource/type/Texture.h"
 #include "resource/Resource.h"
@@ -29,6 +31,8 @@ union Gfx;
 
 namespace Fast {
 
+class Mesh;
+
 constexpr size_t MAX_SEGMENT_POINTERS = 16;
 
 struct GfxExecStack {
@@ -127,6 +131,7 @@ struct ShaderMod {
 
 #define MAX_LIGHTS 32
 #define MAX_VERTICES 64
+#define MAX_EXT_VERTICES 0x10000
 
 struct RSP {
     float modelview_matrix_stack[11][4][4];
@@ -224,6 +229,37 @@ struct GfxTextureCache {
     std::vector<uint32_t> free_texture_ids;
 };
 
+struct VertexCacheKey {
+    const F3DVtx* vertices;
+    uint32_t count;
+    uint64_t state_hash; // transform, lighting, texgen and fog state the vertices were processed with
+
+    bool operator==(const VertexCacheKey&) const noexcept = default;
+
+    struct Hasher {
+        size_t operator()(const VertexCacheKey& key) const noexcept {
+            uintptr_t addr = (uintptr_t)key.vertices;
+            return (size_t)(addr ^ (addr >> 5) ^ key.state_hash ^ key.count);
+        }
+    };
+};
+
+struct VertexCacheValue {
+    uint64_t data_hash; // hash of the source vertices, guards against the data changing behind the same pointer
+    std::vector<LoadedVertex> vertices;
+    std::list<VertexCacheKey>::iterator lru_location;
+};
+
+struct GfxVertexCache {
+    std::unordered_map<VertexCacheKey, VertexCacheValue, VertexCacheKey::Hasher> map;
+    std::list<VertexCacheKey> lru;
+    size_t budget_bytes = 0; // 0 disables the cache
+    size_t used_bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
 struct ColorCombiner {
     uint64_t shader_id0;
     uint32_t shader_id1;
@@ -232,6 +268,41 @@ struct ColorCombiner {
     uint8_t shader_input_mapping[2][7];
 };
 
+// What EmitTriangle needs from the render state that PrepareTriangleState applied.
+struct TriangleDrawState {
+    ColorCombiner* comb;
+    uint32_t tm; // clamp flags of both textures, 2 bits each
+    uint32_t tex_width[2], tex_height[2], tex_width2[2], tex_height2[2];
+    uint8_t num_inputs;
+    bool used_textures[2];
+    bool use_alpha;
+    bool use_fog;
+    bool use_grayscale;
+    struct GfxClipParameters clip_parameters;
+};
+
+struct MeshBufferKey {
+    const Mesh* mesh;
+    uint64_t state_hash; // transform, culling and RDP state the triangles were built with
+
+    bool operator==(const MeshBufferKey&) const noexcept = default;
+
+    struct Hasher {
+        size_t operator()(const MeshBufferKey& key) const noexcept {
+            uintptr_t addr = (uintptr_t)key.mesh;
+            return (size_t)(addr ^ (addr >> 5) ^ key.state_hash);
+        }
+    };
+};
+
+struct MeshBuffer {
+    std::weak_ptr<Mesh> mesh; // the mesh the entry was made for, a different one may reuse its address
+    uint32_t frame;           // mMeshFrame when the mesh was last drawn with this state
+    bool retained;            // triangles were built, and uploaded to buffer_id if any survived culling
+    uint32_t buffer_id;
+    size_t num_tris;
+};
+
 struct RenderingState {
     uint8_t depth_test_and_mask; // 1: depth test, 2: depth mask
     bool decal_mode;
@@ -308,12 +379,30 @@ class Interpreter {
     void ImportTexture(int i, int tile, bool importReplacement);
     void ImportTextureMask(int i, int tile);
     void CalculateNormalDir(const F3DLight_t*, float coeffs[3]);
+    void UpdateLightCoeffs();
+    void VertexCacheClear();
+    void SetVertexCacheBudget(size_t bytes);
+    uint64_t VertexCacheStateHash() const;
+    bool VertexCacheLookup(const VertexCacheKey& key, uint64_t dataHash, size_t destIndex);
+    void VertexCacheInsert(const VertexCacheKey& key, uint64_t dataHash, size_t destIndex);
 
     void GfxSpMatrix(uint8_t params, const int32_t* addr);
     void GfxSpPopMatrix(uint32_t count);
     void GfxSpVertex(size_t numVertices, size_t destIndex, const F3DVtx* vertices);
+    void TransformVertices(size_t numVertices, LoadedVertex* dest, const F3DVtx* vertices);
     void GfxSpModifyVertex(uint16_t vtxIdx, uint8_t where, uint32_t val);
     void GfxSpTri1(uint8_t vtx1Idx, uint8_t vtx2Idx, uint8_t vtx3Idx, bool isRect);
+    void GfxSpTri(LoadedVertex* v1, LoadedVertex* v2, LoadedVertex* v3, bool isRect);
+    bool CullTriangle(const LoadedVertex* v1, const LoadedVertex* v2, const LoadedVertex* v3) const;
+    void PrepareTriangleState(TriangleDrawState& state);
+    size_t EmitTriangle(float* buf, const TriangleDrawState& state, LoadedVertex* v1, LoadedVertex* v2,
+                        LoadedVertex* v3, bool isRect);
+    void GfxSpVertexExt(size_t numVertices, size_t destIndex, const F3DVtx* vertices);
+    void GfxSpTriIndexed(const uint16_t* indices, size_t numIndices);
+    void GfxSpMesh(const std::shared_ptr<Mesh>& mesh);
+    uint64_t MeshBufferStateHash(const TriangleDrawState& state) const;
+    void SweepMeshBuffers();
+    void MeshBuffersClear();
     void GfxSpGeometryMode(uint32_t clear, uint32_t set);
     void GfxSpExtraGeometryMode(uint32_t clear, uint32_t set);
     void GfxSpMovememF3dex2(uint8_t index, uint8_t offset, const void* data);
@@ -375,6 +464,19 @@ class Interpreter {
     RenderingState mRenderingState{};
 
     GfxTextureCache mTextureCache{};
+    GfxVertexCache mVertexCache{};
+    // Vertices loaded by G_VTX_EXT, addressed by G_TRI_INDEXED. Separate from RSP::loaded_vertices.
+    std::vector<LoadedVertex> mVertexArena;
+    // The frame each arena entry was last loaded in. G_TRI_INDEXED only draws entries loaded during this frame.
+    std::vector<uint32_t> mVertexArenaLoads;
+    uint32_t mVertexArenaFrame = 1;
+    // Transformed vertices and built triangles of the mesh being drawn.
+    std::vector<LoadedVertex> mMeshVertices;
+    std::vector<float> mMeshVbo;
+    // Meshes drawn during the current or the previous Run. Those drawn with the same state in both are kept in GPU
+    // buffers.
+    std::unordered_map<MeshBufferKey, MeshBuffer, MeshBufferKey::Hasher> mMeshBuffers;
+    uint32_t mMeshFrame = 1;
     std::map<ColorCombinerKey, ColorCombiner> mColorCombinerPool; // color_combiner_pool;
     std::map<ColorCombinerKey, ColorCombiner>::iterator mPrevCombiner = mColorCombinerPool.end();
     uint8_t* mTexUploadBuffer = nullptr;
@@ -416,12 +518,14 @@ class Interpreter {
     std::vector<std::string> shader_ids;
     int mInterpolationIndex;
     int mInterpolationIndexTarget;
+    GfxProfiler mProfiler;
 };
 
 void gfx_set_target_ucode(UcodeHandlers ucode);
 void gfx_push_current_dir(char* path);
 int32_t gfx_check_image_signature(const char* imgData);
 const char* GfxGetOpcodeName(int8_t opcode);
+const char* GfxGetOpcodeNameForUcode(UcodeHandlers ucode, int8_t opcode);
 
 } // namespace Fast
 
@@ -70,6 +70,10 @@ constexpr int8_t OTR_G_MOVEMEM_HASH = OPCODE(0x42);
 constexpr int8_t OTR_G_LOAD_SHADER = OPCODE(0x43);
 constexpr int8_t RDP_G_SETTILESIZE_INTERP = OPCODE(0x44);
 constexpr int8_t RDP_G_SETTARGETINTERPINDEX = OPCODE(0x45);
+constexpr int8_t OTR_G_MESH_OTR_HASH = OPCODE(0x46);
+constexpr int8_t OTR_G_MESH_OTR_FILEPATH = OPCODE(0x47);
+constexpr int8_t OTR_G_VTX_EXT = OPCODE(0x48);
+constexpr int8_t OTR_G_TRI_INDEXED = OPCODE(0x49);
 
 /*
  * The following commands are the "generated" RDP commands; the user
@@ -157,6 +157,10 @@ void ResourceLoadDirectoryAsync(const char* name) {
     Ship::Context::GetInstance()->GetResourceManager()->LoadResourcesAsync(name);
 }
 
+void ResourceSetPrefetchMarker(const char* marker) {
+    Ship::Context::GetInstance()->GetResourceManager()->SetPrefetchMarker(marker);
+}
+
 uint32_t ResourceHasGameVersion(uint32_t hash) {
     auto list = Ship::Context::GetInstance()->GetResourceManager()->GetArchiveManager()->GetGameVersions();
     return std::find(list.begin(), list.end(), hash) != list.end();
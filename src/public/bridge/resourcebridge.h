@@ -38,6 +38,7 @@ size_t ResourceGetTexSizeByName(const char* name);
 size_t ResourceGetTexSizeByCrc(uint64_t crc);
 void ResourceLoadDirectory(const char* name);
 void ResourceLoadDirectoryAsync(const char* name);
+void ResourceSetPrefetchMarker(const char* marker);
 void ResourceDirtyDirectory(const char* name);
 void ResourceDirtyByName(const char* name);
 void ResourceDirtyByCrc(uint64_t crc);
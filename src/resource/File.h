@@ -32,7 +32,26 @@ struct ResourceInitData {
 
 struct File {
     std::shared_ptr<std::vector<char>> Buffer;
+    // Set instead of Buffer when the data is read in place from memory kept alive by the archive, such as a mapped
+    // archive file. Use GetData and GetDataSize to read either.
+    std::shared_ptr<const char> View;
+    size_t ViewSize = 0;
+    // Where the resource data starts in Buffer. Non-zero when a legacy OTR header is left in front of the data.
+    size_t BufferOffset = 0;
     std::variant<std::shared_ptr<tinyxml2::XMLDocument>, std::shared_ptr<BinaryReader>> Reader;
     bool IsLoaded = false;
+
+    const char* GetData() const {
+        return View != nullptr ? View.get() + BufferOffset : Buffer->data() + BufferOffset;
+    }
+
+    size_t GetDataSize() const {
+        return View != nullptr ? ViewSize - BufferOffset : Buffer->size() - BufferOffset;
+    }
+
+    // Non-virtual reader over the resource data, for factories that decode large arrays.
+    SpanReader GetSpanReader(Endianness endianness) const {
+        return SpanReader(GetData(), GetDataSize(), endianness);
+    }
 };
 } // namespace Ship
@@ -82,13 +82,23 @@ std::shared_ptr<ResourceFactory> ResourceLoader::GetFactory(uint32_t format, std
     return GetFactory(format, mResourceTypes[typeName], version);
 }
 
+// Streams the file's data, starting past anything the loader already skipped, without copying it.
+static std::shared_ptr<MemoryStream> CreateFileStream(const std::shared_ptr<File>& file) {
+    if (file->View != nullptr) {
+        return std::make_shared<MemoryStream>(std::shared_ptr<const char>(file->View, file->GetData()),
+                                              file->GetDataSize());
+    }
+
+    return std::make_shared<MemoryStream>(file->Buffer, file->BufferOffset);
+}
+
 std::shared_ptr<ResourceInitData> ResourceLoader::ReadResourceInitDataLegacy(const std::string& filePath,
                                                                              std::shared_ptr<File> fileToLoad) {
     // Determine if file is binary or XML...
-    if (fileToLoad->Buffer->at(0) == '<') {
+    if (fileToLoad->GetDataSize() > 0 && fileToLoad->GetData()[0] == '<') {
         // File is XML
         // Read the xml document
-        auto stream = std::make_shared<MemoryStream>(fileToLoad->Buffer);
+        auto stream = CreateFileStream(fileToLoad);
         auto binaryReader = std::make_shared<BinaryReader>(stream);
 
         auto xmlReader = std::make_shared<tinyxml2::XMLDocument>();
@@ -100,31 +110,28 @@ std::shared_ptr<ResourceInitData> ResourceLoader::ReadResourceInitDataLegacy(con
         }
         return ReadResourceInitDataXml(filePath, xmlReader);
     } else {
-        auto headerBuffer = std::make_shared<std::vector<char>>(fileToLoad->Buffer->begin(),
-                                                                fileToLoad->Buffer->begin() + OTR_HEADER_SIZE);
-
-        if (headerBuffer->size() < OTR_HEADER_SIZE) {
+        if (fileToLoad->GetDataSize() < OTR_HEADER_SIZE) {
             SPDLOG_ERROR("Failed to parse ResourceInitData, buffer size too small. File: {}. Got {} bytes and "
                          "needed {} bytes.",
-                         filePath, headerBuffer->size(), OTR_HEADER_SIZE);
+                         filePath, fileToLoad->GetDataSize(), OTR_HEADER_SIZE);
             return nullptr;
         }
 
-        // Factories expect the buffer to not include the header,
-        // so we need to remove it from the buffer on the file
-        fileToLoad->Buffer = std::make_shared<std::vector<char>>(fileToLoad->Buffer->begin() + OTR_HEADER_SIZE,
-                                                                 fileToLoad->Buffer->end());
-
-        // Create a reader for the header buffer
-        auto headerStream = std::make_shared<MemoryStream>(headerBuffer);
+        // Create a reader for the header, it only reads the start of the buffer
+        auto headerStream = CreateFileStream(fileToLoad);
         auto headerReader = std::make_shared<BinaryReader>(headerStream);
+
+        // Factories expect the data to not include the header. Rather than copying everything after it into a new
+        // buffer, skip over it and let the readers view the rest of the original buffer.
+        fileToLoad->BufferOffset = OTR_HEADER_SIZE;
+
         return ReadResourceInitDataBinary(filePath, headerReader);
     }
 }
 
 std::shared_ptr<BinaryReader> ResourceLoader::CreateBinaryReader(std::shared_ptr<File> fileToLoad,
                                                                  std::shared_ptr<ResourceInitData> initData) {
-    auto stream = std::make_shared<MemoryStream>(fileToLoad->Buffer);
+    auto stream = CreateFileStream(fileToLoad);
     auto reader = std::make_shared<BinaryReader>(stream);
     reader->SetEndianness(initData->ByteOrder);
     return reader;
@@ -132,7 +139,7 @@ std::shared_ptr<BinaryReader> ResourceLoader::CreateBinaryReader(std::shared_ptr
 
 std::shared_ptr<tinyxml2::XMLDocument> ResourceLoader::CreateXMLReader(std::shared_ptr<File> fileToLoad,
                                                                        std::shared_ptr<ResourceInitData> initData) {
-    auto stream = std::make_shared<MemoryStream>(fileToLoad->Buffer);
+    auto stream = CreateFileStream(fileToLoad);
     auto binaryReader = std::make_shared<BinaryReader>(stream);
 
     auto xmlReader = std::make_shared<tinyxml2::XMLDocument>();
@@ -158,29 +165,12 @@ std::shared_ptr<ResourceInitData> ResourceLoader::CreateDefaultResourceInitData(
 }
 
 std::shared_ptr<ResourceInitData> ResourceLoader::ReadResourceInitData(const std::string& filePath,
-                                                                       std::shared_ptr<File> metaFileToLoad) {
+                                                                       const ResourceSidecar& sidecar) {
     auto initData = CreateDefaultResourceInitData();
-
-    // just using metaFileToLoad->Buffer->data() leads to garbage at the end
-    // that causes nlohmann to fail parsing, following the pattern used for
-    // xml resolves that issue
-    auto stream = std::make_shared<MemoryStream>(metaFileToLoad->Buffer);
-    auto binaryReader = std::make_shared<BinaryReader>(stream);
-    auto parsed = nlohmann::json::parse(binaryReader->ReadCString());
-
-    if (parsed.contains("path")) {
-        initData->Path = parsed["path"];
-    } else {
-        initData->Path = filePath;
-    }
-
-    auto formatString = parsed["format"];
-    if (formatString == "XML") {
-        initData->Format = RESOURCE_FORMAT_XML;
-    }
-
-    initData->Type = Context::GetInstance()->GetResourceManager()->GetResourceLoader()->GetResourceType(parsed["type"]);
-    initData->ResourceVersion = parsed["version"];
+    initData->Path = sidecar.Path;
+    initData->Format = sidecar.Format;
+    initData->Type = GetResourceType(sidecar.Type);
+    initData->ResourceVersion = sidecar.ResourceVersion;
 
     return initData;
 }
@@ -193,13 +183,14 @@ std::shared_ptr<IResource> ResourceLoader::LoadResource(std::string filePath, st
     }
 
     if (initData == nullptr) {
-        auto metaFilePath = filePath + ".meta";
-        auto metaFileToLoad = Context::GetInstance()->GetResourceManager()->LoadFileProcess(metaFilePath);
-
-        if (metaFileToLoad != nullptr) {
-            auto initDataFromMetaFile = ReadResourceInitData(filePath, metaFileToLoad);
-            fileToLoad = Context::GetInstance()->GetResourceManager()->LoadFileProcess(initDataFromMetaFile->Path);
-            initData = initDataFromMetaFile;
+        // Sidecars are indexed and parsed when archives are mounted, so resources without one cost nothing extra here.
+        auto sidecar = Context::GetInstance()->GetResourceManager()->GetArchiveManager()->GetResourceSidecar(filePath);
+
+        if (sidecar != nullptr) {
+            initData = ReadResourceInitData(filePath, *sidecar);
+            if (initData->Path != filePath) {
+                fileToLoad = Context::GetInstance()->GetResourceManager()->LoadFileProcess(initData->Path);
+            }
         } else {
             initData = ReadResourceInitDataLegacy(filePath, fileToLoad);
         }
@@ -210,6 +201,12 @@ std::shared_ptr<IResource> ResourceLoader::LoadResource(std::string filePath, st
         return nullptr;
     }
 
+    // Files too short for a header, empty files and XML that doesn't parse have no init data.
+    if (initData == nullptr) {
+        SPDLOG_ERROR("Failed to read resource init data for the resource at path: {}", filePath);
+        return nullptr;
+    }
+
     switch (initData->Format) {
         case RESOURCE_FORMAT_BINARY:
             fileToLoad->Reader = CreateBinaryReader(fileToLoad, initData);
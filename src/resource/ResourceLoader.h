@@ -8,6 +8,7 @@
 
 namespace Ship {
 struct File;
+struct ResourceSidecar;
 
 struct ResourceFactoryKey {
     uint32_t resourceFormat;
@@ -44,7 +45,7 @@ class ResourceLoader {
     std::shared_ptr<ResourceFactory> GetFactory(uint32_t format, uint32_t type, uint32_t version);
     std::shared_ptr<ResourceFactory> GetFactory(uint32_t format, std::string typeName, uint32_t version);
     std::shared_ptr<ResourceInitData> ReadResourceInitData(const std::string& filePath,
-                                                           std::shared_ptr<File> metaFileToLoad);
+                                                           const ResourceSidecar& sidecar);
     static std::shared_ptr<ResourceInitData> CreateDefaultResourceInitData();
     std::shared_ptr<ResourceInitData> ReadResourceInitDataLegacy(const std::string& filePath,
                                                                  std::shared_ptr<File> fileToLoad);
@@ -4,8 +4,11 @@
 #include "resource/archive/Archive.h"
 #include <algorithm>
 #include <thread>
+#include <fstream>
+#include <filesystem>
 #include "utils/StringHelper.h"
 #include "utils/Utils.h"
+#include "utils/StrHash64.h"
 #include "public/bridge/consolevariablebridge.h"
 #include "Context.h"
 
@@ -16,32 +19,82 @@ ResourceFilter::ResourceFilter(const std::list<std::string>& includeMasks, const
     : IncludeMasks(includeMasks), ExcludeMasks(excludeMasks), Owner(owner), Parent(parent) {
 }
 
+// Parents are compared by pointer, so they are hashed by pointer as well.
+static size_t HashResourceIdentifier(size_t pathHash, uintptr_t owner, const Archive* parent) {
+    size_t hash = Math::HashCombine(pathHash, std::hash<std::uintptr_t>{}(owner));
+    if (parent != nullptr) {
+        hash = Math::HashCombine(hash, std::hash<const Archive*>{}(parent));
+    }
+    return hash;
+}
+
 size_t ResourceIdentifier::GetHash() const {
     return mHash;
 }
 
 ResourceIdentifier::ResourceIdentifier(const std::string& path, const uintptr_t owner,
                                        const std::shared_ptr<Archive> parent)
-    : Path(path), Owner(owner), Parent(parent) {
+    : ResourceIdentifier(ResourcePathTable::GetInstance().Intern(path), owner, parent) {
+}
+
+ResourceIdentifier::ResourceIdentifier(std::shared_ptr<const InternedResourcePath> path, const uintptr_t owner,
+                                       const std::shared_ptr<Archive> parent)
+    : Path(path->Path), Owner(owner), Parent(parent), mInternedPath(std::move(path)) {
     mHash = CalculateHash();
 }
 
 bool ResourceIdentifier::operator==(const ResourceIdentifier& rhs) const {
-    return Owner == rhs.Owner && Path == rhs.Path && Parent == rhs.Parent;
+    // Interned paths are unique, so comparing the pointers compares the paths.
+    return Owner == rhs.Owner && mInternedPath == rhs.mInternedPath && Parent == rhs.Parent;
+}
+
+uint64_t ResourceIdentifier::GetCrc() const {
+    return mInternedPath->Crc;
+}
+
+bool ResourceIdentifier::IsAltPath() const {
+    return mInternedPath->IsAltPath;
+}
+
+ResourceIdentifier ResourceIdentifier::GetAltIdentifier() const {
+    return { ResourcePathTable::GetInstance().GetAltPath(mInternedPath), Owner, Parent };
 }
 
 size_t ResourceIdentifier::CalculateHash() {
-    size_t hash = Math::HashCombine(std::hash<std::string>{}(Path), std::hash<std::uintptr_t>{}(Owner));
-    if (Parent != nullptr) {
-        hash = Math::HashCombine(hash, std::hash<std::string>{}(Parent->GetPath()));
-    }
-    return hash;
+    // The path hash is computed once when it is interned.
+    return HashResourceIdentifier(mInternedPath->Hash, Owner, Parent.get());
+}
+
+ResourceCacheKey::ResourceCacheKey(std::string_view path, const uintptr_t owner, const Archive* parent)
+    : Path(path), Owner(owner), Parent(parent),
+      Hash(HashResourceIdentifier(std::hash<std::string_view>{}(path), owner, parent)) {
+}
+
+ResourceCacheKey::ResourceCacheKey(const ResourceIdentifier& identifier)
+    : Path(identifier.Path), Owner(identifier.Owner), Parent(identifier.Parent.get()),
+      Hash(ResourceIdentifierHash{}(identifier)) {
 }
 
 size_t ResourceIdentifierHash::operator()(const ResourceIdentifier& rcd) const {
     return rcd.GetHash();
 }
 
+size_t ResourceIdentifierHash::operator()(const ResourceCacheKey& key) const {
+    return key.Hash;
+}
+
+bool ResourceIdentifierEqual::operator()(const ResourceIdentifier& lhs, const ResourceIdentifier& rhs) const {
+    return lhs == rhs;
+}
+
+bool ResourceIdentifierEqual::operator()(const ResourceCacheKey& lhs, const ResourceIdentifier& rhs) const {
+    return lhs.Owner == rhs.Owner && lhs.Parent == rhs.Parent.get() && lhs.Path == rhs.Path;
+}
+
+bool ResourceIdentifierEqual::operator()(const ResourceIdentifier& lhs, const ResourceCacheKey& rhs) const {
+    return (*this)(rhs, lhs);
+}
+
 ResourceManager::ResourceManager() {
 }
 
@@ -55,6 +108,8 @@ void ResourceManager::Init(const std::vector<std::string>& archivePaths,
     size_t threadCount = std::max(1, (int32_t)(std::thread::hardware_concurrency() - reservedThreadCount - 1));
     mThreadPool = std::make_shared<BS::thread_pool>(threadCount);
 
+    SetMemoryBudget((size_t)CVarGetInteger(CVAR_RESOURCE_CACHE_BUDGET, 0) * 1024 * 1024);
+
     if (!IsLoaded()) {
         // Nothing ever unpauses the thread pool since nothing will ever try to load the archive again.
         mThreadPool->pause();
@@ -63,6 +118,7 @@ void ResourceManager::Init(const std::vector<std::string>& archivePaths,
 
 ResourceManager::~ResourceManager() {
     SPDLOG_INFO("destruct ResourceManager");
+    FlushPrefetchManifest();
 }
 
 bool ResourceManager::IsLoaded() {
@@ -70,7 +126,15 @@ bool ResourceManager::IsLoaded() {
 }
 
 std::shared_ptr<File> ResourceManager::LoadFileProcess(const std::string& filePath) {
-    auto file = mArchiveManager->LoadFile(filePath);
+    return LoadFileProcess(filePath, CRC64(filePath.c_str()));
+}
+
+std::shared_ptr<File> ResourceManager::LoadFileProcess(const std::string& filePath, uint64_t hash) {
+    if (filePath == "") {
+        return nullptr;
+    }
+
+    auto file = mArchiveManager->LoadFile(hash);
     if (file != nullptr) {
         SPDLOG_TRACE("Loaded File {} on ResourceManager", filePath);
     } else {
@@ -80,11 +144,15 @@ std::shared_ptr<File> ResourceManager::LoadFileProcess(const std::string& filePa
 }
 
 std::shared_ptr<File> ResourceManager::LoadFileProcess(const ResourceIdentifier& identifier) {
+    // The path was hashed when it was interned, so neither branch hashes it again.
     if (identifier.Parent == nullptr) {
-        return LoadFileProcess(identifier.Path);
+        return LoadFileProcess(identifier.Path, identifier.GetCrc());
     }
     auto archive = identifier.Parent;
-    auto file = archive->LoadFile(identifier.Path);
+    const auto entries = archive->GetEntryTable();
+    auto entry = entries->Entries.find(identifier.GetCrc());
+    auto file = entry != entries->Entries.end() ? archive->LoadFile(identifier.Path, *entries, entry->second)
+                                                : archive->LoadFile(identifier.Path);
     if (file != nullptr) {
         SPDLOG_TRACE("Loaded File {} on ResourceManager", identifier.Path);
     } else {
@@ -103,9 +171,8 @@ std::shared_ptr<IResource> ResourceManager::LoadResourceProcess(const ResourceId
 
     // Attempt to load the alternate version of the asset, if we fail then we continue trying to load the standard
     // asset.
-    if (!loadExact && mAltAssetsEnabled && !identifier.Path.starts_with(IResource::gAltAssetPrefix)) {
-        const auto altPath = IResource::gAltAssetPrefix + identifier.Path;
-        auto altResource = LoadResourceProcess({ altPath, identifier.Owner, identifier.Parent }, loadExact, initData);
+    if (!loadExact && mAltAssetsEnabled && !identifier.IsAltPath()) {
+        auto altResource = LoadResourceProcess(identifier.GetAltIdentifier(), loadExact, initData);
 
         if (altResource != nullptr) {
             return altResource;
@@ -122,7 +189,7 @@ std::shared_ptr<IResource> ResourceManager::LoadResourceProcess(const ResourceId
 
     // Check for resource load errors which can indicate an alternate asset.
     // If we are attempting to load an alternate asset, we can return null
-    if (!loadExact && mAltAssetsEnabled && identifier.Path.starts_with(IResource::gAltAssetPrefix)) {
+    if (!loadExact && mAltAssetsEnabled && identifier.IsAltPath()) {
         if (std::holds_alternative<ResourceLoadError>(cacheLine)) {
             try {
                 // If we have attempted to cache an alternate asset, but failed, we return nullptr and rely on the
@@ -138,36 +205,15 @@ std::shared_ptr<IResource> ResourceManager::LoadResourceProcess(const ResourceId
     }
 
     // Get the file from the OTR
-    auto file = LoadFileProcess(identifier.Path);
+    auto file = LoadFileProcess(identifier.Path, identifier.GetCrc());
     if (file == nullptr) {
         SPDLOG_TRACE("Failed to load resource file at path {}", identifier.Path);
-        mResourceCache[identifier] = ResourceLoadError::NotFound;
+        SetCacheLine(identifier, nullptr);
         return nullptr;
     }
 
     // Transform the raw data into a resource
-    auto resource = GetResourceLoader()->LoadResource(identifier.Path, file, initData);
-
-    // Another thread could have loaded the resource while we were processing, so we want to check before setting to
-    // the cache.
-    cachedResource = GetCachedResource(identifier, true);
-
-    {
-        const std::lock_guard<std::mutex> lock(mMutex);
-
-        if (cachedResource != nullptr) {
-            // If another thread has already loaded this resource, discard the work we already did and return from
-            // cache.
-            resource = cachedResource;
-        }
-
-        // Set the cache to the loaded resource
-        if (resource != nullptr) {
-            mResourceCache[identifier] = resource;
-        } else {
-            mResourceCache[identifier] = ResourceLoadError::NotFound;
-        }
-    }
+    auto resource = SetCacheLine(identifier, GetResourceLoader()->LoadResource(identifier.Path, file, initData));
 
     if (resource != nullptr) {
         SPDLOG_TRACE("Loaded Resource {} on ResourceManager", identifier.Path);
@@ -183,28 +229,213 @@ std::shared_ptr<IResource> ResourceManager::LoadResourceProcess(const std::strin
     return LoadResourceProcess({ filePath, mDefaultCacheOwner, mDefaultCacheArchive }, loadExact, initData);
 }
 
-std::shared_future<std::shared_ptr<IResource>>
-ResourceManager::LoadResourceAsync(const ResourceIdentifier& identifier, bool loadExact, BS::priority_t priority,
-                                   std::shared_ptr<ResourceInitData> initData) {
+ResourceLoadToken::ResourceLoadToken(ResourceManager* manager, const ResourceIdentifier& identifier, bool loadExact,
+                                     BS::priority_t priority, std::shared_ptr<ResourceInitData> initData)
+    : mManager(manager), mIdentifier(identifier), mLoadExact(loadExact), mInitData(initData), mPriority(priority),
+      mFuture(mPromise.get_future().share()) {
+}
+
+bool ResourceLoadToken::TryClaim() {
+    State expected = State::Queued;
+    return mState.compare_exchange_strong(expected, State::Running);
+}
+
+void ResourceLoadToken::Complete(std::shared_ptr<IResource> resource) {
+    mState = State::Done;
+    mPromise.set_value(resource);
+}
+
+bool ResourceLoadToken::Cancel() {
+    State expected = State::Queued;
+    if (!mState.compare_exchange_strong(expected, State::Cancelled)) {
+        return false;
+    }
+
+    // Any pool task still queued for this token will find it cancelled and return without doing anything.
+    mPromise.set_value(nullptr);
+    mManager->ForgetQueuedResourceLoad(shared_from_this());
+    return true;
+}
+
+void ResourceLoadToken::RaisePriority(BS::priority_t priority) {
+    if (mState != State::Queued || priority <= mPriority) {
+        return;
+    }
+
+    // The thread pool can't reorder a queued task, so queue another one at the new priority. Whichever task runs
+    // first claims the token, the other one becomes a no-op.
+    mPriority = priority;
+    mManager->SubmitResourceLoad(shared_from_this(), priority);
+}
+
+bool ResourceLoadToken::IsCancelled() const {
+    return mState == State::Cancelled;
+}
+
+bool ResourceLoadToken::IsDone() const {
+    return mState == State::Done;
+}
+
+BS::priority_t ResourceLoadToken::GetPriority() const {
+    return mPriority;
+}
+
+std::shared_future<std::shared_ptr<IResource>> ResourceLoadToken::GetFuture() const {
+    return mFuture;
+}
+
+std::shared_ptr<ResourceLoadToken> ResourceManager::QueueResourceLoad(const ResourceIdentifier& identifier,
+                                                                      bool loadExact, BS::priority_t priority,
+                                                                      std::shared_ptr<ResourceInitData> initData) {
     // Check for and remove the OTR signature
     if (OtrSignatureCheck(identifier.Path.c_str())) {
         auto newFilePath = identifier.Path.substr(7);
-        return LoadResourceAsync({ newFilePath, identifier.Owner, identifier.Parent }, loadExact, priority);
+        return QueueResourceLoad({ newFilePath, identifier.Owner, identifier.Parent }, loadExact, priority, initData);
     }
 
+    auto token = std::make_shared<ResourceLoadToken>(this, identifier, loadExact, priority, initData);
+
     // Check the cache before queueing the job.
-    auto cacheCheck = GetCachedResource(identifier, loadExact);
+    const ResourceCacheKey key(identifier);
+    auto cacheCheck = GetCachedResource(CheckCache(key, loadExact, &key));
     if (cacheCheck) {
-        auto promise = std::make_shared<std::promise<std::shared_ptr<IResource>>>();
-        promise->set_value(cacheCheck);
-        return promise->get_future().share();
+        token->TryClaim();
+        token->Complete(cacheCheck);
+        return token;
     }
 
-    return mThreadPool->submit_task(
-        [this, identifier, loadExact, initData]() -> std::shared_ptr<IResource> {
-            return LoadResourceProcess(identifier, loadExact, initData);
-        },
-        priority);
+    RecordPrefetchAccess(key);
+
+    {
+        const std::lock_guard<std::mutex> lock(mQueuedLoadsMutex);
+        mQueuedLoads[identifier].push_back(token);
+    }
+
+    SubmitResourceLoad(token, priority);
+    return token;
+}
+
+std::shared_ptr<ResourceLoadToken> ResourceManager::QueueResourceLoad(const std::string& filePath, bool loadExact,
+                                                                      BS::priority_t priority,
+                                                                      std::shared_ptr<ResourceInitData> initData) {
+    return QueueResourceLoad({ filePath, mDefaultCacheOwner, mDefaultCacheArchive }, loadExact, priority, initData);
+}
+
+void ResourceManager::SubmitResourceLoad(std::shared_ptr<ResourceLoadToken> token, BS::priority_t priority) {
+    mThreadPool->detach_task([this, token]() { RunResourceLoad(token); }, priority);
+}
+
+void ResourceManager::RunResourceLoad(const std::shared_ptr<ResourceLoadToken>& token) {
+    if (!token->TryClaim()) {
+        return;
+    }
+
+    ForgetQueuedResourceLoad(token);
+
+    try {
+        token->Complete(LoadResourceDeduplicated(token->mIdentifier, token->mLoadExact, token->mInitData));
+    } catch (...) {
+        token->mState = ResourceLoadToken::State::Done;
+        token->mPromise.set_exception(std::current_exception());
+    }
+}
+
+void ResourceManager::ForgetQueuedResourceLoad(const std::shared_ptr<ResourceLoadToken>& token) {
+    const std::lock_guard<std::mutex> lock(mQueuedLoadsMutex);
+    auto queuedFind = mQueuedLoads.find(token->mIdentifier);
+    if (queuedFind == mQueuedLoads.end()) {
+        return;
+    }
+
+    // Tokens that were dropped without running are cleaned up along the way.
+    auto& tokens = queuedFind->second;
+    auto isForgotten = [&token](const std::weak_ptr<ResourceLoadToken>& queued) {
+        auto queuedToken = queued.lock();
+        return queuedToken == nullptr || queuedToken == token;
+    };
+    tokens.erase(std::remove_if(tokens.begin(), tokens.end(), isForgotten), tokens.end());
+    if (tokens.empty()) {
+        mQueuedLoads.erase(queuedFind);
+    }
+}
+
+bool ResourceManager::RunQueuedResourceLoad(const ResourceIdentifier& identifier) {
+    std::shared_ptr<ResourceLoadToken> token;
+
+    {
+        const std::lock_guard<std::mutex> lock(mQueuedLoadsMutex);
+        auto queuedFind = mQueuedLoads.find(identifier);
+        if (queuedFind == mQueuedLoads.end()) {
+            return false;
+        }
+
+        // One load is enough, the tokens still queued for the resource find it cached when they run.
+        for (const auto& queued : queuedFind->second) {
+            token = queued.lock();
+            if (token != nullptr) {
+                break;
+            }
+        }
+    }
+
+    if (token == nullptr) {
+        return false;
+    }
+
+    // Take the queued load over instead of waiting behind whatever else is queued on the pool.
+    RunResourceLoad(token);
+    return true;
+}
+
+std::shared_future<std::shared_ptr<IResource>>
+ResourceManager::LoadResourceAsync(const ResourceIdentifier& identifier, bool loadExact, BS::priority_t priority,
+                                   std::shared_ptr<ResourceInitData> initData) {
+    return QueueResourceLoad(identifier, loadExact, priority, initData)->GetFuture();
+}
+
+std::shared_ptr<IResource> ResourceManager::LoadResourceDeduplicated(const ResourceIdentifier& identifier,
+                                                                     bool loadExact,
+                                                                     std::shared_ptr<ResourceInitData> initData) {
+    std::promise<std::shared_ptr<IResource>> promise;
+    std::shared_future<std::shared_ptr<IResource>> inFlight;
+    bool isOwner = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(mInFlightMutex);
+        auto inFlightFind = mInFlightLoads.find(identifier);
+        if (inFlightFind == mInFlightLoads.end()) {
+            mInFlightLoads.emplace(identifier, InFlightLoad{ loadExact, promise.get_future().share() });
+            isOwner = true;
+        } else if (inFlightFind->second.LoadExact == loadExact) {
+            inFlight = inFlightFind->second.Future;
+        }
+    }
+
+    // Someone else is already loading this exact request, wait for their result.
+    if (inFlight.valid()) {
+        return inFlight.get();
+    }
+
+    // The same identifier is being loaded with a different loadExact, which can resolve to a different resource.
+    if (!isOwner) {
+        return LoadResourceProcess(identifier, loadExact, initData);
+    }
+
+    std::shared_ptr<IResource> resource;
+    try {
+        resource = LoadResourceProcess(identifier, loadExact, initData);
+        promise.set_value(resource);
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        const std::lock_guard<std::mutex> lock(mInFlightMutex);
+        mInFlightLoads.erase(identifier);
+        throw;
+    }
+
+    const std::lock_guard<std::mutex> lock(mInFlightMutex);
+    mInFlightLoads.erase(identifier);
+
+    return resource;
 }
 
 std::shared_future<std::shared_ptr<IResource>>
@@ -215,7 +446,24 @@ ResourceManager::LoadResourceAsync(const std::string& filePath, bool loadExact,
 
 std::shared_ptr<IResource> ResourceManager::LoadResource(const ResourceIdentifier& identifier, bool loadExact,
                                                          std::shared_ptr<ResourceInitData> initData) {
-    auto resource = LoadResourceAsync(identifier, loadExact, BS::pr::highest, initData).get();
+    // Check for and remove the OTR signature
+    if (OtrSignatureCheck(identifier.Path.c_str())) {
+        const auto newFilePath = identifier.Path.substr(7);
+        return LoadResource({ newFilePath, identifier.Owner, identifier.Parent }, loadExact, initData);
+    }
+
+    // Synchronous loads never go through the thread pool. A cache hit is returned directly, and a miss is loaded on
+    // the calling thread, which also means a pool thread calling LoadResource can no longer wait on the pool itself.
+    const ResourceCacheKey key(identifier);
+    auto resource = GetCachedResource(CheckCache(key, loadExact, &key));
+    if (resource == nullptr) {
+        RecordPrefetchAccess(key);
+        // If the resource is queued on the pool, run that load right here, then pick up the result below. If it is
+        // already running somewhere, the deduplicated load waits for it.
+        RunQueuedResourceLoad(identifier);
+        resource = LoadResourceDeduplicated(identifier, loadExact, initData);
+    }
+
     if (resource == nullptr) {
         SPDLOG_TRACE("Failed to load resource file at path {}", identifier.Path);
     }
@@ -224,14 +472,31 @@ std::shared_ptr<IResource> ResourceManager::LoadResource(const ResourceIdentifie
 
 std::shared_ptr<IResource> ResourceManager::LoadResource(const std::string& filePath, bool loadExact,
                                                          std::shared_ptr<ResourceInitData> initData) {
+    // Cache hits are found by the path alone. The identifier, which interns the path and holds on to the archive, is
+    // only built when the resource has to be loaded.
+    if (!OtrSignatureCheck(filePath.c_str())) {
+        const ResourceCacheKey key(filePath, mDefaultCacheOwner, mDefaultCacheArchive.get());
+        auto resource = GetCachedResource(CheckCache(key, loadExact, &key));
+        if (resource != nullptr) {
+            return resource;
+        }
+    }
+
     return LoadResource({ filePath, mDefaultCacheOwner, mDefaultCacheArchive }, loadExact, initData);
 }
 
 std::variant<ResourceManager::ResourceLoadError, std::shared_ptr<IResource>>
 ResourceManager::CheckCache(const ResourceIdentifier& identifier, bool loadExact) {
-    if (!loadExact && mAltAssetsEnabled && !identifier.Path.starts_with(IResource::gAltAssetPrefix)) {
-        const auto altPath = IResource::gAltAssetPrefix + identifier.Path;
-        auto altCacheResult = CheckCache({ altPath, identifier.Owner, identifier.Parent }, loadExact);
+    return CheckCache(ResourceCacheKey(identifier), loadExact);
+}
+
+std::variant<ResourceManager::ResourceLoadError, std::shared_ptr<IResource>>
+ResourceManager::CheckCache(const ResourceCacheKey& key, bool loadExact, const ResourceCacheKey* requestedKey) {
+    if (!loadExact && mAltAssetsEnabled && !key.Path.starts_with(IResource::gAltAssetPrefix)) {
+        // The buffer is reused by every lookup on this thread, so looking up the alt path doesn't allocate.
+        thread_local std::string sAltPath;
+        sAltPath.assign(IResource::gAltAssetPrefix).append(key.Path);
+        auto altCacheResult = CheckCache(ResourceCacheKey(sAltPath, key.Owner, key.Parent), loadExact, requestedKey);
 
         // If the type held at this cache index is a resource, then we return it.
         // Else we attempt to load standard definition assets.
@@ -240,19 +505,329 @@ ResourceManager::CheckCache(const ResourceIdentifier& identifier, bool loadExact
         }
     }
 
-    const std::lock_guard<std::mutex> lock(mMutex);
+    auto& shard = GetCacheShard(key.Hash);
+    const std::shared_lock<std::shared_mutex> lock(shard.Mutex);
 
-    auto cacheFind = mResourceCache.find(identifier);
-    if (cacheFind == mResourceCache.end()) {
+    auto cacheFind = shard.Cache.find(key);
+    if (cacheFind == shard.Cache.end()) {
         return ResourceLoadError::NotCached;
     }
 
-    return cacheFind->second;
+    // Most hits are in the same epoch as the previous one, so skip the store and leave the entry's line clean.
+    const uint64_t epoch = mAccessEpoch.load(std::memory_order_relaxed);
+    if (cacheFind->second.LastAccess.load(std::memory_order_relaxed) != epoch) {
+        cacheFind->second.LastAccess.store(epoch, std::memory_order_relaxed);
+    }
+    if (requestedKey != nullptr) {
+        RecordPrefetchHit(cacheFind->second, *requestedKey);
+    }
+    return cacheFind->second.Line;
+}
+
+ResourceManager::ResourceCacheShard& ResourceManager::GetCacheShard(const ResourceIdentifier& identifier) {
+    return GetCacheShard(ResourceIdentifierHash{}(identifier));
+}
+
+ResourceManager::ResourceCacheShard& ResourceManager::GetCacheShard(size_t hash) {
+    // Fibonacci hashing on the top bits, so the shard index does not correlate with the bucket the shard's own map
+    // picks from the low bits of the same hash.
+    const uint64_t shardHash = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+    return mResourceCacheShards[(shardHash >> 32) % RESOURCE_CACHE_SHARD_COUNT];
+}
+
+std::shared_ptr<IResource> ResourceManager::SetCacheLine(const ResourceIdentifier& identifier,
+                                                         std::shared_ptr<IResource> resource) {
+    const size_t size = resource != nullptr ? resource->GetPointerSize() : 0;
+    // Hold on to the replaced resource until the lock is released, see UnloadResource.
+    std::variant<ResourceLoadError, std::shared_ptr<IResource>> replaced;
+
+    {
+        auto& shard = GetCacheShard(identifier);
+        const std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+        auto [entry, inserted] = shard.Cache.try_emplace(identifier);
+        if (!inserted) {
+            // Another thread could have loaded the resource while we were processing. If so, discard the work we
+            // already did and return the cached one.
+            auto cachedResource = GetCachedResource(entry->second.Line);
+            if (cachedResource != nullptr) {
+                return cachedResource;
+            }
+
+            replaced = std::move(entry->second.Line);
+            mResidentBytes -= entry->second.Size;
+        }
+
+        if (resource != nullptr) {
+            entry->second.Line = resource;
+        } else {
+            entry->second.Line = ResourceLoadError::NotFound;
+        }
+        entry->second.Size = size;
+        entry->second.LastAccess.store(mAccessEpoch.fetch_add(1, std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+        mResidentBytes += size;
+    }
+
+    EvictResources();
+
+    return resource;
+}
+
+void ResourceManager::EvictResources() {
+    const size_t budget = mMemoryBudget;
+    if (budget == 0 || mResidentBytes <= budget) {
+        return;
+    }
+
+    // One thread evicting at a time is enough, everyone else just keeps loading.
+    std::unique_lock<std::mutex> evictionLock(mEvictionMutex, std::try_to_lock);
+    if (!evictionLock.owns_lock()) {
+        return;
+    }
+
+    // Evict down to a bit below the budget so that we don't end up scanning the cache again on the very next load.
+    const size_t target = budget - budget / 8;
+    // Anything looked up after the scan stores a later epoch than every candidate, which is what the second check
+    // below relies on.
+    mAccessEpoch.fetch_add(1, std::memory_order_relaxed);
+
+    struct EvictionCandidate {
+        uint64_t LastAccess;
+        ResourceCacheShard* Shard;
+        ResourceIdentifier Identifier;
+    };
+    std::vector<EvictionCandidate> candidates;
+
+    // A candidate is a loaded resource that only the cache itself holds a reference to.
+    for (auto& shard : mResourceCacheShards) {
+        const std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+        for (auto& [identifier, entry] : shard.Cache) {
+            const auto resource = std::get_if<std::shared_ptr<IResource>>(&entry.Line);
+            if (resource == nullptr || *resource == nullptr || resource->use_count() > 1 ||
+                shard.Pinned.contains(identifier)) {
+                continue;
+            }
+            candidates.push_back({ entry.LastAccess.load(std::memory_order_relaxed), &shard, identifier });
+        }
+    }
+
+    // ResourceIdentifier is not assignable, so sort an index list instead of the candidates themselves.
+    std::vector<size_t> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [&candidates](size_t a, size_t b) { return candidates[a].LastAccess < candidates[b].LastAccess; });
+
+    std::vector<decltype(ResourceCacheShard::Cache)::node_type> evicted;
+    for (size_t i : order) {
+        const auto& candidate = candidates[i];
+        if (mResidentBytes <= target) {
+            break;
+        }
+
+        const std::unique_lock<std::shared_mutex> lock(candidate.Shard->Mutex);
+        // Nobody can grab a new reference while we hold the exclusive lock, so checking again here is race free. A
+        // resource that was looked up since the scan is no longer the least recently used one, so it is skipped.
+        auto cacheFind = candidate.Shard->Cache.find(candidate.Identifier);
+        if (cacheFind == candidate.Shard->Cache.end() ||
+            cacheFind->second.LastAccess.load(std::memory_order_relaxed) != candidate.LastAccess) {
+            continue;
+        }
+        const auto resource = std::get_if<std::shared_ptr<IResource>>(&cacheFind->second.Line);
+        if (resource == nullptr || *resource == nullptr || resource->use_count() > 1 ||
+            candidate.Shard->Pinned.contains(cacheFind->first)) {
+            continue;
+        }
+
+        mResidentBytes -= cacheFind->second.Size;
+        mEvictedBytes += cacheFind->second.Size;
+        mEvictedCount++;
+        evicted.push_back(candidate.Shard->Cache.extract(cacheFind));
+    }
+
+    if (!evicted.empty()) {
+        SPDLOG_TRACE("Evicted {} resources from the resource cache", evicted.size());
+    }
+    // The evicted resources are destroyed here, after every shard lock has been released.
+}
+
+void ResourceManager::SetPrefetchMarker(const std::string& marker) {
+    FlushPrefetchManifest();
+    mPrefetchGeneration++;
+
+    {
+        const std::lock_guard<std::mutex> lock(mPrefetchMutex);
+        mPrefetchMarker = marker;
+        mPrefetchAccessOrder.clear();
+        mPrefetchAccessed.clear();
+        mPrefetchRecording = true;
+    }
+
+    PrefetchManifest(marker);
+}
+
+void ResourceManager::FlushPrefetchManifest() {
+    std::string marker;
+    std::vector<std::string> accessOrder;
+
+    {
+        const std::lock_guard<std::mutex> lock(mPrefetchMutex);
+        if (!mPrefetchRecording) {
+            return;
+        }
+
+        mPrefetchRecording = false;
+        marker = std::move(mPrefetchMarker);
+        accessOrder = std::move(mPrefetchAccessOrder);
+        mPrefetchAccessed.clear();
+    }
+
+    if (accessOrder.empty()) {
+        return;
+    }
+
+    const auto path = GetPrefetchManifestPath(marker);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    std::ofstream manifest(path, std::ios::out | std::ios::trunc);
+    if (!manifest.is_open()) {
+        SPDLOG_ERROR("Failed to write prefetch manifest {}", path);
+        return;
+    }
+
+    for (const auto& resourcePath : accessOrder) {
+        manifest << resourcePath << "\n";
+    }
+
+    SPDLOG_INFO("Recorded {} resources for prefetch marker {}", accessOrder.size(), marker);
+}
+
+void ResourceManager::RecordPrefetchAccess(const ResourceCacheKey& key) {
+    if (!mPrefetchRecording) {
+        return;
+    }
+
+    // Manifests only store paths, so only requests that a path alone can reproduce are recorded.
+    if (key.Owner != mDefaultCacheOwner || key.Parent != mDefaultCacheArchive.get()) {
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(mPrefetchMutex);
+    if (mPrefetchRecording && mPrefetchAccessed.emplace(key.Path).second) {
+        mPrefetchAccessOrder.emplace_back(key.Path);
+    }
+}
+
+void ResourceManager::RecordPrefetchHit(ResourceCacheEntry& entry, const ResourceCacheKey& key) {
+    if (!mPrefetchRecording.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Resources that were prefetched are hits from then on, they still have to be recorded or the next manifest
+    // would lose them. Only the first hit per marker gets that far.
+    const uint32_t generation = mPrefetchGeneration.load(std::memory_order_relaxed);
+    if (entry.PrefetchGeneration.exchange(generation, std::memory_order_relaxed) != generation) {
+        RecordPrefetchAccess(key);
+    }
+}
+
+void ResourceManager::PrefetchManifest(const std::string& marker) {
+    std::ifstream manifest(GetPrefetchManifestPath(marker));
+    if (!manifest.is_open()) {
+        return;
+    }
+
+    auto paths = std::make_shared<std::vector<std::string>>();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty()) {
+            paths->push_back(line);
+        }
+    }
+
+    if (paths->empty()) {
+        return;
+    }
+
+    SPDLOG_TRACE("Prefetching {} resources for marker {}", paths->size(), marker);
+
+    // A single task walks the manifest so that resources arrive in the order they were first needed. It runs below
+    // normal priority, so demand loads queued meanwhile are picked up first.
+    const uint32_t generation = mPrefetchGeneration;
+    mThreadPool->detach_task(
+        [this, paths, generation]() {
+            for (const auto& path : *paths) {
+                if (mPrefetchGeneration != generation) {
+                    return;
+                }
+
+                const ResourceIdentifier identifier = { path, mDefaultCacheOwner, mDefaultCacheArchive };
+                if (GetCachedResource(identifier) == nullptr) {
+                    LoadResourceDeduplicated(identifier, false, nullptr);
+                }
+            }
+        },
+        BS::pr::low);
+}
+
+std::string ResourceManager::GetPrefetchManifestPath(const std::string& marker) {
+    std::string fileName = marker;
+    for (auto& c : fileName) {
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') {
+            c = '_';
+        }
+    }
+
+    return Context::GetPathRelativeToAppDirectory("prefetch/" + fileName + ".txt");
+}
+
+void ResourceManager::SetMemoryBudget(size_t bytes) {
+    mMemoryBudget = bytes;
+    EvictResources();
+}
+
+size_t ResourceManager::GetMemoryBudget() {
+    return mMemoryBudget;
+}
+
+void ResourceManager::PinResource(const ResourceIdentifier& identifier) {
+    auto& shard = GetCacheShard(identifier);
+    const std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+    shard.Pinned.insert(identifier);
+}
+
+void ResourceManager::PinResource(const std::string& filePath) {
+    PinResource({ filePath, mDefaultCacheOwner, mDefaultCacheArchive });
+}
+
+void ResourceManager::UnpinResource(const ResourceIdentifier& identifier) {
+    auto& shard = GetCacheShard(identifier);
+    const std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+    shard.Pinned.erase(identifier);
+}
+
+void ResourceManager::UnpinResource(const std::string& filePath) {
+    UnpinResource({ filePath, mDefaultCacheOwner, mDefaultCacheArchive });
+}
+
+size_t ResourceManager::GetResidentBytes() {
+    return mResidentBytes;
+}
+
+size_t ResourceManager::GetEvictedBytes() {
+    return mEvictedBytes;
+}
+
+size_t ResourceManager::GetEvictedCount() {
+    return mEvictedCount;
 }
 
 std::variant<ResourceManager::ResourceLoadError, std::shared_ptr<IResource>>
 ResourceManager::CheckCache(const std::string& filePath, bool loadExact) {
-    return CheckCache({ filePath, mDefaultCacheOwner, mDefaultCacheArchive }, loadExact);
+    return CheckCache(ResourceCacheKey(filePath, mDefaultCacheOwner, mDefaultCacheArchive.get()), loadExact);
 }
 
 std::shared_ptr<IResource> ResourceManager::GetCachedResource(const ResourceIdentifier& identifier, bool loadExact) {
@@ -262,7 +837,7 @@ std::shared_ptr<IResource> ResourceManager::GetCachedResource(const ResourceIden
 
 std::shared_ptr<IResource> ResourceManager::GetCachedResource(const std::string& filePath, bool loadExact) {
     // Gets the cached resource based on filePath.
-    return GetCachedResource({ filePath, mDefaultCacheOwner, mDefaultCacheArchive }, loadExact);
+    return GetCachedResource(CheckCache(filePath, loadExact));
 }
 
 std::shared_ptr<IResource>
@@ -289,57 +864,136 @@ ResourceManager::GetCachedResource(std::variant<ResourceLoadError, std::shared_p
     return nullptr;
 }
 
+struct ResourceManager::ResourceLoadBatch {
+    ResourceLoadBatch(const ResourceFilter& filter, std::shared_ptr<std::vector<std::string>> files,
+                      size_t chunkSize, ResourceLoadProgressCallback progress)
+        : Filter(filter), Files(files), Resources(std::make_shared<std::vector<std::shared_ptr<IResource>>>()),
+          ChunkSize(chunkSize), ChunkCount((files->size() + chunkSize - 1) / chunkSize), Progress(progress) {
+        Resources->resize(Files->size());
+    }
+
+    const ResourceFilter Filter;
+    const std::shared_ptr<std::vector<std::string>> Files;
+    // Every file owns one slot, so chunks can write their results without locking.
+    const std::shared_ptr<std::vector<std::shared_ptr<IResource>>> Resources;
+    const size_t ChunkSize;
+    const size_t ChunkCount;
+    const ResourceLoadProgressCallback Progress;
+    std::atomic<size_t> NextChunk = 0;
+    std::atomic<size_t> Loaded = 0;
+    std::atomic<size_t> CompletedChunks = 0;
+    std::atomic<bool> Failed = false;
+    std::promise<void> Done;
+};
+
+void ResourceManager::LoadResourceBatchChunks(ResourceLoadBatch& batch) {
+    const size_t total = batch.Files->size();
+
+    // Keep claiming chunks until there are none left. The chunk size keeps the claiming overhead low while still
+    // leaving enough chunks for late threads to help out.
+    for (size_t chunk = batch.NextChunk++; chunk < batch.ChunkCount; chunk = batch.NextChunk++) {
+        const size_t begin = chunk * batch.ChunkSize;
+        const size_t end = std::min(begin + batch.ChunkSize, total);
+
+        try {
+            for (size_t i = begin; i < end; i++) {
+                (*batch.Resources)[i] = LoadResource({ (*batch.Files)[i], batch.Filter.Owner, batch.Filter.Parent });
+            }
+        } catch (...) {
+            if (!batch.Failed.exchange(true)) {
+                batch.Done.set_exception(std::current_exception());
+            }
+        }
+
+        const size_t loaded = batch.Loaded += end - begin;
+        if (batch.Progress) {
+            batch.Progress(loaded, total);
+        }
+
+        if (++batch.CompletedChunks == batch.ChunkCount && !batch.Failed) {
+            batch.Done.set_value();
+        }
+    }
+}
+
 std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
-ResourceManager::LoadResourcesProcess(const ResourceFilter& filter) {
-    auto loadedList = std::make_shared<std::vector<std::shared_ptr<IResource>>>();
+ResourceManager::LoadResourcesProcess(const ResourceFilter& filter, BS::priority_t priority,
+                                      ResourceLoadProgressCallback progress) {
     auto fileList = GetArchiveManager()->ListFiles(filter.IncludeMasks, filter.ExcludeMasks);
-    loadedList->reserve(fileList->size());
+    if (fileList->empty()) {
+        if (progress) {
+            progress(0, 0);
+        }
+        return std::make_shared<std::vector<std::shared_ptr<IResource>>>();
+    }
 
-    for (size_t i = 0; i < fileList->size(); i++) {
-        auto fileName = std::string(fileList->operator[](i));
-        auto resource = LoadResource({ fileName, filter.Owner, filter.Parent });
-        loadedList->push_back(resource);
+    // Aim for a few chunks per thread so that threads which finish early can pick up remaining work.
+    const size_t threadCount = mThreadPool->get_thread_count();
+    const size_t chunkSize = std::max<size_t>(1, fileList->size() / (threadCount * 4));
+    auto batch = std::make_shared<ResourceLoadBatch>(filter, fileList, chunkSize, progress);
+
+    // The calling thread works on the batch as well, so only spawn helpers for the remaining chunks.
+    const size_t helperCount = std::min(threadCount, batch->ChunkCount - 1);
+    for (size_t i = 0; i < helperCount; i++) {
+        mThreadPool->detach_task([this, batch]() { LoadResourceBatchChunks(*batch); }, priority);
     }
 
-    return loadedList;
+    LoadResourceBatchChunks(*batch);
+
+    // Helpers may still be finishing the chunks they claimed.
+    batch->Done.get_future().get();
+    return batch->Resources;
 }
 
 std::shared_future<std::shared_ptr<std::vector<std::shared_ptr<IResource>>>>
-ResourceManager::LoadResourcesAsync(const ResourceFilter& filter, BS::priority_t priority) {
+ResourceManager::LoadResourcesAsync(const ResourceFilter& filter, BS::priority_t priority,
+                                    ResourceLoadProgressCallback progress) {
     return mThreadPool->submit_task(
-        [this, filter]() -> std::shared_ptr<std::vector<std::shared_ptr<IResource>>> {
-            return LoadResourcesProcess(filter);
+        [this, filter, priority, progress]() -> std::shared_ptr<std::vector<std::shared_ptr<IResource>>> {
+            return LoadResourcesProcess(filter, priority, progress);
         },
         priority);
 }
 
 std::shared_future<std::shared_ptr<std::vector<std::shared_ptr<IResource>>>>
-ResourceManager::LoadResourcesAsync(const std::string& searchMask, BS::priority_t priority) {
-    return LoadResourcesAsync({ { searchMask }, {}, mDefaultCacheOwner, mDefaultCacheArchive }, priority);
+ResourceManager::LoadResourcesAsync(const std::string& searchMask, BS::priority_t priority,
+                                    ResourceLoadProgressCallback progress) {
+    return LoadResourcesAsync({ { searchMask }, {}, mDefaultCacheOwner, mDefaultCacheArchive }, priority, progress);
 }
 
-std::shared_ptr<std::vector<std::shared_ptr<IResource>>> ResourceManager::LoadResources(const std::string& searchMask) {
-    return LoadResources({ { searchMask }, {}, mDefaultCacheOwner, mDefaultCacheArchive });
+std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
+ResourceManager::LoadResources(const std::string& searchMask, ResourceLoadProgressCallback progress) {
+    return LoadResources({ { searchMask }, {}, mDefaultCacheOwner, mDefaultCacheArchive }, progress);
 }
 
-std::shared_ptr<std::vector<std::shared_ptr<IResource>>> ResourceManager::LoadResources(const ResourceFilter& filter) {
-    return LoadResourcesAsync(filter, BS::pr::highest).get();
+std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
+ResourceManager::LoadResources(const ResourceFilter& filter, ResourceLoadProgressCallback progress) {
+    // Runs on the calling thread, with the pool helping out at the highest priority.
+    return LoadResourcesProcess(filter, BS::pr::highest, progress);
 }
 
 void ResourceManager::DirtyResources(const ResourceFilter& filter) {
     mThreadPool->submit_task([this, filter]() -> void {
         auto list = GetArchiveManager()->ListFiles(filter.IncludeMasks, filter.ExcludeMasks);
+        DirtyResourcesProcess(*list, filter.Owner, filter.Parent);
+    });
+}
 
-        for (const auto& key : *list.get()) {
-            auto resource = GetCachedResource({ key, filter.Owner, filter.Parent });
-            // If it's a resource, we will set the dirty flag, else we will just unload it.
-            if (resource != nullptr) {
-                resource->Dirty();
-            } else {
-                UnloadResource({ key, filter.Owner, filter.Parent });
-            }
+void ResourceManager::DirtyResources(const std::vector<std::string>& filePaths) {
+    DirtyResourcesProcess(filePaths, mDefaultCacheOwner, mDefaultCacheArchive);
+}
+
+void ResourceManager::DirtyResourcesProcess(const std::vector<std::string>& filePaths, uintptr_t owner,
+                                            std::shared_ptr<Archive> parent) {
+    for (const auto& key : filePaths) {
+        auto resource = GetCachedResource({ key, owner, parent });
+        // If it's a resource, we will set the dirty flag, else we will just unload it.
+        if (resource != nullptr) {
+            resource->Dirty();
+        } else {
+            UnloadResource({ key, owner, parent });
         }
-    });
+    }
 }
 
 void ResourceManager::DirtyResources(const std::string& searchMask) {
@@ -379,15 +1033,20 @@ std::shared_ptr<ResourceLoader> ResourceManager::GetResourceLoader() {
 }
 
 size_t ResourceManager::UnloadResource(const ResourceIdentifier& identifier) {
-    // Store a shared pointer here so that erase doesn't destruct the resource.
-    // The resource will attempt to load other resources on the destructor, and this will fail because we already hold
-    // the mutex.
-    std::variant<ResourceLoadError, std::shared_ptr<IResource>> value = nullptr;
+    // Keep the cache entry alive until the lock is released so that erase doesn't destruct the resource.
+    // The resource may attempt to load other resources on the destructor, and those could land in this same shard.
+    decltype(ResourceCacheShard::Cache)::node_type node;
     size_t ret = 0;
-    // We can only erase the resource if we have any resources for that owner.
-    if (mResourceCache.contains(identifier)) {
-        const std::lock_guard<std::mutex> lock(mMutex);
-        mResourceCache.erase(identifier);
+
+    {
+        auto& shard = GetCacheShard(identifier);
+        const std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+        node = shard.Cache.extract(identifier);
+    }
+
+    if (!node.empty()) {
+        mResidentBytes -= node.mapped().Size;
+        ret = 1;
     }
 
     return ret;
@@ -3,13 +3,21 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
+#include <array>
+#include <atomic>
 #include <queue>
 #include <variant>
+#include <functional>
+#include <future>
+#include <memory>
 #include "resource/Resource.h"
 #include "resource/ResourceLoader.h"
+#include "resource/ResourcePathTable.h"
 #include "resource/archive/Archive.h"
 #include "resource/archive/ArchiveManager.h"
 
@@ -34,25 +42,99 @@ struct ResourceIdentifier {
     friend struct ResourceIdentifierHash;
 
     ResourceIdentifier(const std::string& path, const uintptr_t owner, const std::shared_ptr<Archive> parent);
+    ResourceIdentifier(std::shared_ptr<const InternedResourcePath> path, const uintptr_t owner,
+                       const std::shared_ptr<Archive> parent);
     bool operator==(const ResourceIdentifier& rhs) const;
 
+    uint64_t GetCrc() const;
+    bool IsAltPath() const;
+    // The same identifier with the path prefixed by alt/
+    ResourceIdentifier GetAltIdentifier() const;
+
     // Must be an exact path. Passing a path with a wildcard will return a fail state
-    const std::string Path = "";
+    // Refers to the interned copy of the path, which lives as long as the identifier.
+    const std::string& Path;
     const uintptr_t Owner = 0;
     const std::shared_ptr<Archive> Parent = nullptr;
 
   private:
     size_t GetHash() const;
     size_t CalculateHash();
+    std::shared_ptr<const InternedResourcePath> mInternedPath;
     size_t mHash;
 };
 
+// Refers to a resource without interning its path or holding on to its archive, so the cache can be searched before
+// an identifier is built. The path has to outlive the key.
+struct ResourceCacheKey {
+    ResourceCacheKey(std::string_view path, const uintptr_t owner, const Archive* parent);
+    explicit ResourceCacheKey(const ResourceIdentifier& identifier);
+
+    const std::string_view Path;
+    const uintptr_t Owner;
+    const Archive* Parent;
+    // Same as the hash of the identifier it refers to.
+    const size_t Hash;
+};
+
 struct ResourceIdentifierHash {
+    using is_transparent = void;
+
     size_t operator()(const ResourceIdentifier& rcd) const;
+    size_t operator()(const ResourceCacheKey& key) const;
 };
 
+struct ResourceIdentifierEqual {
+    using is_transparent = void;
+
+    bool operator()(const ResourceIdentifier& lhs, const ResourceIdentifier& rhs) const;
+    bool operator()(const ResourceCacheKey& lhs, const ResourceIdentifier& rhs) const;
+    bool operator()(const ResourceIdentifier& lhs, const ResourceCacheKey& rhs) const;
+};
+
+class ResourceManager;
+
+// Handle to a queued asynchronous resource load. A load that has not started yet can be cancelled, or moved ahead of
+// other queued work by raising its priority.
+class ResourceLoadToken : public std::enable_shared_from_this<ResourceLoadToken> {
+    friend class ResourceManager;
+
+  public:
+    ResourceLoadToken(ResourceManager* manager, const ResourceIdentifier& identifier, bool loadExact,
+                      BS::priority_t priority, std::shared_ptr<ResourceInitData> initData);
+
+    // Returns false if the load already started or finished. A cancelled load resolves to nullptr.
+    bool Cancel();
+    // Requeues the load at a higher priority. Lowering the priority is not supported.
+    void RaisePriority(BS::priority_t priority);
+    bool IsCancelled() const;
+    bool IsDone() const;
+    BS::priority_t GetPriority() const;
+    std::shared_future<std::shared_ptr<IResource>> GetFuture() const;
+
+  private:
+    enum class State { Queued, Running, Done, Cancelled };
+
+    // Moves the token from Queued to Running. Only one thread can ever succeed.
+    bool TryClaim();
+    void Complete(std::shared_ptr<IResource> resource);
+
+    ResourceManager* mManager;
+    const ResourceIdentifier mIdentifier;
+    const bool mLoadExact;
+    const std::shared_ptr<ResourceInitData> mInitData;
+    std::atomic<State> mState = State::Queued;
+    std::atomic<BS::priority_t> mPriority;
+    std::promise<std::shared_ptr<IResource>> mPromise;
+    std::shared_future<std::shared_ptr<IResource>> mFuture;
+};
+
+// Reports how many files of a batch load are done. Called from whichever thread finished the files.
+typedef std::function<void(size_t loaded, size_t total)> ResourceLoadProgressCallback;
+
 class ResourceManager {
     friend class ResourceLoader;
+    friend class ResourceLoadToken;
     typedef enum class ResourceLoadError { None, NotCached, NotFound } ResourceLoadError;
 
   public:
@@ -82,47 +164,153 @@ class ResourceManager {
     std::shared_future<std::shared_ptr<IResource>>
     LoadResourceAsync(const ResourceIdentifier& identifier, bool loadExact = false,
                       BS::priority_t priority = BS::pr::normal, std::shared_ptr<ResourceInitData> initData = nullptr);
+    // Same as LoadResourceAsync, but returns a token that can cancel or reprioritize the load while it is queued.
+    // A synchronous LoadResource for a queued resource takes the load over and runs it on the calling thread.
+    std::shared_ptr<ResourceLoadToken> QueueResourceLoad(const std::string& filePath, bool loadExact = false,
+                                                         BS::priority_t priority = BS::pr::normal,
+                                                         std::shared_ptr<ResourceInitData> initData = nullptr);
+    std::shared_ptr<ResourceLoadToken> QueueResourceLoad(const ResourceIdentifier& identifier, bool loadExact = false,
+                                                         BS::priority_t priority = BS::pr::normal,
+                                                         std::shared_ptr<ResourceInitData> initData = nullptr);
     size_t UnloadResource(const ResourceIdentifier& identifier);
     size_t UnloadResource(const std::string& filePath);
 
-    std::shared_ptr<std::vector<std::shared_ptr<IResource>>> LoadResources(const std::string& searchMask);
-    std::shared_ptr<std::vector<std::shared_ptr<IResource>>> LoadResources(const ResourceFilter& filter);
+    std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
+    LoadResources(const std::string& searchMask, ResourceLoadProgressCallback progress = nullptr);
+    std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
+    LoadResources(const ResourceFilter& filter, ResourceLoadProgressCallback progress = nullptr);
     std::shared_future<std::shared_ptr<std::vector<std::shared_ptr<IResource>>>>
-    LoadResourcesAsync(const std::string& searchMask, BS::priority_t priority = BS::pr::normal);
+    LoadResourcesAsync(const std::string& searchMask, BS::priority_t priority = BS::pr::normal,
+                       ResourceLoadProgressCallback progress = nullptr);
     std::shared_future<std::shared_ptr<std::vector<std::shared_ptr<IResource>>>>
-    LoadResourcesAsync(const ResourceFilter& filter, BS::priority_t priority = BS::pr::normal);
+    LoadResourcesAsync(const ResourceFilter& filter, BS::priority_t priority = BS::pr::normal,
+                       ResourceLoadProgressCallback progress = nullptr);
 
     void DirtyResources(const std::string& searchMask);
     void DirtyResources(const ResourceFilter& filter);
+    // Dirties the exact paths right away instead of on the thread pool, e.g. when the archive providing them changed.
+    void DirtyResources(const std::vector<std::string>& filePaths);
     void UnloadResources(const std::string& searchMask);
     void UnloadResources(const ResourceFilter& filter);
     void UnloadResourcesAsync(const std::string& searchMask, BS::priority_t priority = BS::pr::normal);
     void UnloadResourcesAsync(const ResourceFilter& filter, BS::priority_t priority = BS::pr::normal);
 
+    // Unreferenced resources are evicted, least recently used first, once the cache holds more than this many bytes.
+    // Zero disables eviction. Only shared_ptr references count: raw pointers such as the ones ResourceGetDataByName and
+    // GetRawPointer hand out do not keep a resource cached, so pin anything accessed that way before setting a budget.
+    void SetMemoryBudget(size_t bytes);
+    size_t GetMemoryBudget();
+    // Pinned resources are never evicted. A path can be pinned before the resource is loaded.
+    void PinResource(const ResourceIdentifier& identifier);
+    void PinResource(const std::string& filePath);
+    void UnpinResource(const ResourceIdentifier& identifier);
+    void UnpinResource(const std::string& filePath);
+    size_t GetResidentBytes();
+    size_t GetEvictedBytes();
+    size_t GetEvictedCount();
+
+    // Everything requested after a marker (e.g. a scene change) is recorded in first-touch order and written to a
+    // manifest when the next marker is set. Setting a marker that has a manifest from a previous session prefetches
+    // its resources in that order on the thread pool, below the priority of regular loads.
+    void SetPrefetchMarker(const std::string& marker);
+    void FlushPrefetchManifest();
+
     bool OtrSignatureCheck(const char* fileName);
     bool IsAltAssetsEnabled();
     void SetAltAssetsEnabled(bool isEnabled);
 
   protected:
-    std::shared_ptr<std::vector<std::shared_ptr<IResource>>> LoadResourcesProcess(const ResourceFilter& filter);
+    std::shared_ptr<std::vector<std::shared_ptr<IResource>>>
+    LoadResourcesProcess(const ResourceFilter& filter, BS::priority_t priority, ResourceLoadProgressCallback progress);
     void UnloadResourcesProcess(const ResourceFilter& filter);
+    void DirtyResourcesProcess(const std::vector<std::string>& filePaths, uintptr_t owner,
+                               std::shared_ptr<Archive> parent);
     std::variant<ResourceLoadError, std::shared_ptr<IResource>> CheckCache(const ResourceIdentifier& identifier,
                                                                            bool loadExact = false);
     std::shared_ptr<File> LoadFileProcess(const ResourceIdentifier& identifier);
     std::variant<ResourceLoadError, std::shared_ptr<IResource>> CheckCache(const std::string& filePath,
                                                                            bool loadExact = false);
+    // Records requestedKey for the prefetch manifest on a hit. Alt assets are hits for the path that was requested.
+    std::variant<ResourceLoadError, std::shared_ptr<IResource>>
+    CheckCache(const ResourceCacheKey& key, bool loadExact = false, const ResourceCacheKey* requestedKey = nullptr);
 
     std::shared_ptr<File> LoadFileProcess(const std::string& filePath);
+    // Loads by a hash of filePath that was already computed.
+    std::shared_ptr<File> LoadFileProcess(const std::string& filePath, uint64_t hash);
     std::shared_ptr<IResource> GetCachedResource(std::variant<ResourceLoadError, std::shared_ptr<IResource>> cacheLine);
 
   private:
-    std::unordered_map<ResourceIdentifier, std::variant<ResourceLoadError, std::shared_ptr<IResource>>,
-                       ResourceIdentifierHash>
-        mResourceCache;
+    // The resource cache is split into lock-striped shards so that lookups from the render thread, the game thread
+    // and the loading threads only contend when they touch the same shard. Lookups take a shared lock.
+    static constexpr size_t RESOURCE_CACHE_SHARD_COUNT = 16;
+    struct ResourceCacheEntry {
+        std::variant<ResourceLoadError, std::shared_ptr<IResource>> Line;
+        size_t Size = 0;
+        // Access epoch of the last lookup. Updated under the shared lock by lookups, so it has to be atomic.
+        std::atomic<uint64_t> LastAccess = 0;
+        // Prefetch generation of the last request that hit this entry, so hits only take the prefetch lock once per
+        // marker.
+        std::atomic<uint32_t> PrefetchGeneration = 0;
+    };
+    struct ResourceCacheShard {
+        std::unordered_map<ResourceIdentifier, ResourceCacheEntry, ResourceIdentifierHash, ResourceIdentifierEqual>
+            Cache;
+        std::unordered_set<ResourceIdentifier, ResourceIdentifierHash> Pinned;
+        std::shared_mutex Mutex;
+    };
+
+    // A load that is currently running on some thread. Other threads asking for the same resource wait on it instead
+    // of loading it a second time.
+    struct InFlightLoad {
+        bool LoadExact;
+        std::shared_future<std::shared_ptr<IResource>> Future;
+    };
+
+    // Shared state of one LoadResources call, split into chunks that any thread can pick up.
+    struct ResourceLoadBatch;
+    void LoadResourceBatchChunks(ResourceLoadBatch& batch);
+
+    std::shared_ptr<IResource> LoadResourceDeduplicated(const ResourceIdentifier& identifier, bool loadExact,
+                                                        std::shared_ptr<ResourceInitData> initData);
+    void SubmitResourceLoad(std::shared_ptr<ResourceLoadToken> token, BS::priority_t priority);
+    void RunResourceLoad(const std::shared_ptr<ResourceLoadToken>& token);
+    void ForgetQueuedResourceLoad(const std::shared_ptr<ResourceLoadToken>& token);
+    bool RunQueuedResourceLoad(const ResourceIdentifier& identifier);
+    void RecordPrefetchAccess(const ResourceCacheKey& key);
+    void RecordPrefetchHit(ResourceCacheEntry& entry, const ResourceCacheKey& key);
+    void PrefetchManifest(const std::string& marker);
+    std::string GetPrefetchManifestPath(const std::string& marker);
+    ResourceCacheShard& GetCacheShard(const ResourceIdentifier& identifier);
+    ResourceCacheShard& GetCacheShard(size_t hash);
+    std::shared_ptr<IResource> SetCacheLine(const ResourceIdentifier& identifier, std::shared_ptr<IResource> resource);
+    void EvictResources();
+
+    std::array<ResourceCacheShard, RESOURCE_CACHE_SHARD_COUNT> mResourceCacheShards;
+    std::unordered_map<ResourceIdentifier, InFlightLoad, ResourceIdentifierHash> mInFlightLoads;
+    std::mutex mInFlightMutex;
+    // Loads that are queued on the pool but have not started yet, so synchronous requests can take them over. Every
+    // caller gets a token of its own, so cancelling one doesn't affect the others queued for the same resource.
+    std::unordered_map<ResourceIdentifier, std::vector<std::weak_ptr<ResourceLoadToken>>, ResourceIdentifierHash>
+        mQueuedLoads;
+    std::mutex mQueuedLoadsMutex;
+    std::mutex mEvictionMutex;
+    // Coarse clock for LastAccess. Hits only read it, so lookups on different shards never write a shared cache line.
+    // It is advanced by loads and by every eviction pass.
+    std::atomic<uint64_t> mAccessEpoch = 0;
+    std::atomic<size_t> mMemoryBudget = 0;
+    std::atomic<size_t> mResidentBytes = 0;
+    std::atomic<size_t> mEvictedBytes = 0;
+    std::atomic<size_t> mEvictedCount = 0;
+    std::atomic<bool> mPrefetchRecording = false;
+    // Bumped by every marker so that prefetches for a previous marker stop early.
+    std::atomic<uint32_t> mPrefetchGeneration = 0;
+    std::mutex mPrefetchMutex;
+    std::string mPrefetchMarker;
+    std::vector<std::string> mPrefetchAccessOrder;
+    std::unordered_set<std::string> mPrefetchAccessed;
     std::shared_ptr<ResourceLoader> mResourceLoader;
     std::shared_ptr<ArchiveManager> mArchiveManager;
     std::shared_ptr<BS::thread_pool> mThreadPool;
-    std::mutex mMutex;
     bool mAltAssetsEnabled = false;
     // Private information for which owner and archive are default.
     uintptr_t mDefaultCacheOwner = 0;
@@ -0,0 +1,86 @@
+#include "resource/ResourcePathTable.h"
+#include "resource/Resource.h"
+#include "utils/StrHash64.h"
+
+namespace Ship {
+
+InternedResourcePath::InternedResourcePath(std::string_view path)
+    : Path(path), Crc(CRC64(Path.c_str())), Hash(std::hash<std::string_view>{}(path)),
+      IsAltPath(Path.starts_with(IResource::gAltAssetPrefix)) {
+}
+
+ResourcePathTable& ResourcePathTable::GetInstance() {
+    // Never destroyed, identifiers held by other statics can release their paths after it would have been.
+    static ResourcePathTable* sInstance = new ResourcePathTable();
+    return *sInstance;
+}
+
+std::shared_ptr<const InternedResourcePath> ResourcePathTable::Intern(std::string_view path) {
+    {
+        const std::shared_lock<std::shared_mutex> lock(mMutex);
+        auto find = mIndex.find(path);
+        if (find != mIndex.end()) {
+            auto interned = find->second.lock();
+            if (interned != nullptr) {
+                return interned;
+            }
+        }
+    }
+
+    const std::unique_lock<std::shared_mutex> lock(mMutex);
+    // Another thread could have interned the same path between the two locks. An expired entry belongs to a path
+    // that is about to be released, it's replaced here and its release leaves the new entry alone.
+    auto find = mIndex.find(path);
+    if (find != mIndex.end()) {
+        auto interned = find->second.lock();
+        if (interned != nullptr) {
+            return interned;
+        }
+        mIndex.erase(find);
+    }
+
+    std::shared_ptr<const InternedResourcePath> interned(
+        new InternedResourcePath(path), [this](const InternedResourcePath* released) { Release(released); });
+    mIndex.emplace(interned->Path, interned);
+    return interned;
+}
+
+void ResourcePathTable::Release(const InternedResourcePath* path) {
+    {
+        const std::unique_lock<std::shared_mutex> lock(mMutex);
+        auto find = mIndex.find(path->Path);
+        if (find != mIndex.end() && find->second.expired()) {
+            mIndex.erase(find);
+        }
+    }
+
+    // Outside of the lock, deleting the path can release its alt/ variant.
+    delete path;
+}
+
+std::shared_ptr<const InternedResourcePath>
+ResourcePathTable::GetAltPath(const std::shared_ptr<const InternedResourcePath>& path) {
+    // The path owns its variant, so sharing the path's ownership keeps the variant alive.
+    auto altPath = path->AltPath.load(std::memory_order_acquire);
+    if (altPath != nullptr) {
+        return std::shared_ptr<const InternedResourcePath>(path, altPath);
+    }
+
+    auto interned = Intern(IResource::gAltAssetPrefix + path->Path);
+    {
+        const std::unique_lock<std::shared_mutex> lock(mMutex);
+        if (path->AltPathOwner == nullptr) {
+            path->AltPathOwner = interned;
+            path->AltPath.store(interned.get(), std::memory_order_release);
+        }
+    }
+
+    return interned;
+}
+
+size_t ResourcePathTable::GetCount() {
+    const std::shared_lock<std::shared_mutex> lock(mMutex);
+    return mIndex.size();
+}
+
+} // namespace Ship
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Ship {
+
+// A resource path stored once while it's in use, with everything derived from it computed once.
+struct InternedResourcePath {
+    InternedResourcePath(std::string_view path);
+
+    const std::string Path;
+    const uint64_t Crc;
+    const size_t Hash;
+    const bool IsAltPath;
+    // The interned alt/ variant of this path, filled in the first time it is requested. The path keeps its variant
+    // interned for as long as it is itself.
+    mutable std::atomic<const InternedResourcePath*> AltPath = nullptr;
+    mutable std::shared_ptr<const InternedResourcePath> AltPathOwner;
+};
+
+// Interns resource paths so that identifiers can be compared and hashed as integers. A path is only interned for as
+// long as an identifier refers to it, so the table never holds more paths than the resource cache and the loads in
+// progress. Paths that were requested but don't exist, or belonged to an archive that was since removed, are dropped
+// along with their cache entries.
+class ResourcePathTable {
+  public:
+    static ResourcePathTable& GetInstance();
+
+    std::shared_ptr<const InternedResourcePath> Intern(std::string_view path);
+    std::shared_ptr<const InternedResourcePath> GetAltPath(const std::shared_ptr<const InternedResourcePath>& path);
+    size_t GetCount();
+
+  private:
+    // Called when the last reference to a path is dropped. Must not be called with the lock held.
+    void Release(const InternedResourcePath* path);
+
+    // Keys point into the interned paths, an entry is removed before the path it points into.
+    std::unordered_map<std::string_view, std::weak_ptr<const InternedResourcePath>> mIndex;
+    std::shared_mutex mMutex;
+};
+
+} // namespace Ship
@@ -19,6 +19,7 @@ enum class ResourceType {
     DisplayList = 0x4F444C54, // ODLT
     Light = 0x46669697,       // LGTS
     Matrix = 0x4F4D5458,      // OMTX
+    Mesh = 0x4F4D5348,        // OMSH
     Texture = 0x4F544558,     // OTEX
     Vertex = 0x4F565458,      // OVTX
 };
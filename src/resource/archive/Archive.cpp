@@ -7,16 +7,21 @@
 #include "resource/ResourceLoader.h"
 #include "resource/ResourceType.h"
 #include "utils/binarytools/MemoryStream.h"
-#include "utils/glob.h"
+#include "utils/binarytools/BinaryWriter.h"
+#include "utils/binarytools/SpanReader.h"
+#include "utils/filesystemtools/MappedFile.h"
 #include "utils/StrHash64.h"
 #include "window/Window.h"
+#include <filesystem>
+#include <fstream>
 #include <nlohmann/json.hpp>
 #include <tinyxml2.h>
 
 namespace Ship {
 Archive::Archive(const std::string& path)
-    : mIsLoaded(false), mHasGameVersion(false), mGameVersion(0xFFFFFFFF), mPath(path) {
+    : mIsLoaded(false), mIndexCached(false), mHasGameVersion(false), mGameVersion(0xFFFFFFFF), mPath(path) {
     mHashes = std::make_shared<std::unordered_map<uint64_t, std::string>>();
+    mEntryTable = std::make_shared<ArchiveEntryTable>();
 }
 
 Archive::~Archive() {
@@ -28,17 +33,21 @@ bool Archive::operator==(const Archive& rhs) const {
 }
 
 void Archive::Load() {
+    // A valid index cache fills in the file table up front, so Open() only has to open the archive.
+    mIndexCached = ReadIndexCache();
     bool opened = Open();
+    const bool indexCached = mIndexCached;
+    mIndexCached = false;
+    mCachedEntryTable = nullptr;
 
     auto t = LoadFile("version");
     bool isGameVersionValid = false;
     if (t != nullptr && t->IsLoaded) {
         mHasGameVersion = true;
-        auto stream = std::make_shared<MemoryStream>(t->Buffer->data(), t->Buffer->size());
-        auto reader = std::make_shared<BinaryReader>(stream);
-        Endianness endianness = (Endianness)reader->ReadUByte();
-        reader->SetEndianness(endianness);
-        SetGameVersion(reader->ReadUInt32());
+        SpanReader reader(t->GetData(), t->GetDataSize());
+        Endianness endianness = (Endianness)reader.ReadUByte();
+        reader.SetEndianness(endianness);
+        SetGameVersion(reader.ReadUInt32());
         isGameVersionValid =
             Context::GetInstance()->GetResourceManager()->GetArchiveManager()->IsGameVersionValid(GetGameVersion());
 
@@ -51,12 +60,23 @@ void Archive::Load() {
 
     if (!IsLoaded()) {
         Unload();
+        return;
+    }
+
+    if (!indexCached) {
+        IndexSidecars();
+        WriteIndexCache();
     }
 }
 
 void Archive::Unload() {
     Close();
     SetLoaded(false);
+    ResetDirectoryTree();
+    mHashes->clear();
+    SetEntryTable(std::make_shared<ArchiveEntryTable>());
+    mSidecarPaths.clear();
+    mSidecars.clear();
 }
 
 std::shared_ptr<std::unordered_map<uint64_t, std::string>> Archive::ListFiles() {
@@ -66,10 +86,17 @@ std::shared_ptr<std::unordered_map<uint64_t, std::string>> Archive::ListFiles()
 std::shared_ptr<std::unordered_map<uint64_t, std::string>> Archive::ListFiles(const std::string& filter) {
     auto result = std::make_shared<std::unordered_map<uint64_t, std::string>>();
 
-    std::copy_if(mHashes->begin(), mHashes->end(), std::inserter(*result, result->begin()),
-                 [filter](const std::pair<const int64_t, const std::string&> entry) {
-                     return glob_match(filter.c_str(), entry.second.c_str());
-                 });
+    // Most archives are only ever queried through the archive manager, so the tree is built on the first query.
+    const std::lock_guard<std::mutex> lock(mDirectoryTreeMutex);
+    if (mDirectoryTree == nullptr) {
+        mDirectoryTree = std::make_unique<DirectoryTree>();
+        for (const auto& [hash, filePath] : *mHashes) {
+            mDirectoryTree->AddFile(filePath, hash);
+        }
+    }
+
+    mDirectoryTree->MatchFiles(
+        filter, [&result](uint64_t hash, const std::string& filePath) { result->emplace(hash, filePath); });
 
     return result;
 }
@@ -82,6 +109,45 @@ bool Archive::HasFile(uint64_t hash) {
     return mHashes->count(hash) > 0;
 }
 
+std::shared_ptr<const ArchiveEntryTable> Archive::GetEntryTable() {
+    const std::shared_lock<std::shared_mutex> lock(mEntryTableMutex);
+    return mEntryTable;
+}
+
+void Archive::SetEntryTable(std::shared_ptr<const ArchiveEntryTable> entries) {
+    const std::unique_lock<std::shared_mutex> lock(mEntryTableMutex);
+    mEntryTable = std::move(entries);
+}
+
+std::shared_ptr<ArchiveEntryTable> Archive::CreateEntryTable() {
+    if (mIndexCached && mCachedEntryTable != nullptr) {
+        return std::move(mCachedEntryTable);
+    }
+
+    return std::make_shared<ArchiveEntryTable>();
+}
+
+std::shared_ptr<File> Archive::LoadFile(const std::string& filePath, const ArchiveEntryTable& entries,
+                                        const ArchiveEntry& entry) {
+    return LoadFile(filePath);
+}
+
+bool Archive::BeginWrite() {
+    return true;
+}
+
+bool Archive::CommitWrite() {
+    return true;
+}
+
+void Archive::AbortWrite() {
+}
+
+const ResourceSidecar* Archive::GetResourceSidecar(uint64_t hash) {
+    auto sidecar = mSidecars.find(hash);
+    return sidecar != mSidecars.end() ? &sidecar->second : nullptr;
+}
+
 bool Archive::HasGameVersion() {
     return mHasGameVersion;
 }
@@ -98,6 +164,14 @@ bool Archive::IsLoaded() {
     return mIsLoaded;
 }
 
+bool Archive::CanCacheIndex() {
+    return true;
+}
+
+bool Archive::IsIndexCached() {
+    return mIndexCached;
+}
+
 void Archive::SetLoaded(bool isLoaded) {
     mIsLoaded = isLoaded;
 }
@@ -108,11 +182,271 @@ void Archive::SetGameVersion(uint32_t gameVersion) {
 
 void Archive::IndexFile(const std::string& filePath) {
     if (filePath.length() > 5 && filePath.substr(filePath.length() - 5) == ".meta") {
-        IndexFile(filePath.substr(0, filePath.length() - 5));
+        IndexSidecarPath(filePath);
         return;
     }
 
-    (*mHashes)[CRC64(filePath.c_str())] = filePath;
+    AddFilePath(filePath, CRC64(filePath.c_str()));
+}
+
+void Archive::IndexFile(const std::string& filePath, const ArchiveEntry& entry, ArchiveEntryTable& entries) {
+    const uint64_t hash = CRC64(filePath.c_str());
+    entries.Entries[hash] = entry;
+
+    if (filePath.length() > 5 && filePath.substr(filePath.length() - 5) == ".meta") {
+        IndexSidecarPath(filePath);
+        return;
+    }
+
+    AddFilePath(filePath, hash);
+}
+
+void Archive::IndexSidecarPath(const std::string& metaPath) {
+    const std::string resourcePath = metaPath.substr(0, metaPath.length() - 5);
+    const uint64_t hash = CRC64(resourcePath.c_str());
+    mSidecarPaths[hash] = metaPath;
+    AddFilePath(resourcePath, hash);
+}
+
+void Archive::AddFilePath(const std::string& filePath, uint64_t hash) {
+    ResetDirectoryTree();
+    (*mHashes)[hash] = filePath;
+}
+
+void Archive::ResetDirectoryTree() {
+    const std::lock_guard<std::mutex> lock(mDirectoryTreeMutex);
+    mDirectoryTree = nullptr;
+}
+
+void Archive::IndexSidecars() {
+    mSidecars.clear();
+
+    for (const auto& [hash, metaPath] : mSidecarPaths) {
+        auto metaFile = LoadFile(metaPath);
+        if (metaFile == nullptr || !metaFile->IsLoaded) {
+            SPDLOG_WARN("Failed to load resource sidecar {} from archive {}", metaPath, GetPath());
+            continue;
+        }
+
+        const auto& resourcePath = mHashes->at(hash);
+        // Sidecars can have trailing null bytes, stop at the first one
+        const std::string json(metaFile->GetData(), strnlen(metaFile->GetData(), metaFile->GetDataSize()));
+        auto parsed = nlohmann::json::parse(json, nullptr, false);
+        if (parsed.is_discarded()) {
+            SPDLOG_WARN("Failed to parse resource sidecar {} from archive {}", metaPath, GetPath());
+            continue;
+        }
+
+        // This runs while the archive is mounted, a sidecar that isn't an object or has fields of the wrong type only
+        // fails its own resource.
+        ResourceSidecar sidecar;
+        try {
+            sidecar.Path = parsed.contains("path") ? parsed["path"].get<std::string>() : resourcePath;
+            sidecar.Type = parsed.value("type", "");
+            sidecar.ResourceVersion = parsed.value("version", 0);
+            sidecar.Format = parsed.value("format", "") == "XML" ? RESOURCE_FORMAT_XML : RESOURCE_FORMAT_BINARY;
+        } catch (const nlohmann::json::exception& e) {
+            SPDLOG_WARN("Invalid resource sidecar {} in archive {}: {}", metaPath, GetPath(), e.what());
+            continue;
+        }
+        mSidecars[hash] = std::move(sidecar);
+    }
+}
+
+// The index cache lives next to the archive and holds everything indexing produces: the path strings with their
+// hashes, the entry table and the parsed sidecars. It's only trusted while the archive's size, modification time and a
+// checksum of its first and last bytes match what it was built from, otherwise it's rebuilt on the next load. Folder
+// archives never have one, there's no cheap way to tell if they changed.
+std::string Archive::GetIndexCachePath() {
+    return mPath + ".index";
+}
+
+static constexpr uint32_t INDEX_CACHE_MAGIC = 0x4C555349; // LUSI
+static constexpr uint32_t INDEX_CACHE_VERSION = 1;
+// Archive formats keep their file tables at one end or the other, so checksumming both ends catches rewrites that
+// happen to keep the size and modification time.
+static constexpr size_t INDEX_CACHE_CHECKSUM_HEAD = 4 * 1024;
+static constexpr size_t INDEX_CACHE_CHECKSUM_TAIL = 64 * 1024;
+
+bool Archive::GetIndexCacheKey(uint64_t& archiveSize, int64_t& archiveTime, uint64_t& checksum) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(mPath, error)) {
+        return false;
+    }
+
+    archiveSize = std::filesystem::file_size(mPath, error);
+    archiveTime = static_cast<int64_t>(std::filesystem::last_write_time(mPath, error).time_since_epoch().count());
+    if (error) {
+        return false;
+    }
+
+    std::ifstream file(mPath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const size_t headSize = std::min<uint64_t>(archiveSize, INDEX_CACHE_CHECKSUM_HEAD);
+    const size_t tailSize = std::min<uint64_t>(archiveSize - headSize, INDEX_CACHE_CHECKSUM_TAIL);
+    std::vector<char> buffer(headSize + tailSize);
+    file.read(buffer.data(), headSize);
+    file.seekg(archiveSize - tailSize);
+    file.read(buffer.data() + headSize, tailSize);
+    if (!file.good()) {
+        return false;
+    }
+
+    checksum = crc64(buffer.data(), buffer.size());
+    return true;
+}
+
+bool Archive::ReadIndexCache() {
+    uint64_t archiveSize;
+    int64_t archiveTime;
+    uint64_t checksum;
+    std::error_code error;
+    if (!std::filesystem::exists(GetIndexCachePath(), error) || !GetIndexCacheKey(archiveSize, archiveTime, checksum)) {
+        return false;
+    }
+
+    auto cacheFile = MappedFile::Open(GetIndexCachePath());
+    if (cacheFile == nullptr) {
+        return false;
+    }
+
+    SpanReader reader(cacheFile->GetData(), cacheFile->GetSize(), Endianness::Little);
+    auto hashes = std::make_shared<std::unordered_map<uint64_t, std::string>>();
+    auto entries = std::make_shared<ArchiveEntryTable>();
+    std::unordered_map<uint64_t, std::string> sidecarPaths;
+    std::unordered_map<uint64_t, ResourceSidecar> sidecars;
+
+    try {
+        if (reader.ReadUInt32() != INDEX_CACHE_MAGIC || reader.ReadUInt32() != INDEX_CACHE_VERSION ||
+            reader.ReadUInt64() != archiveSize || reader.ReadInt64() != archiveTime ||
+            reader.ReadUInt64() != checksum) {
+            SPDLOG_INFO("Index cache for archive {} is out of date, rebuilding it", GetPath());
+            return false;
+        }
+
+        const uint32_t fileCount = reader.ReadUInt32();
+        hashes->reserve(fileCount);
+        for (uint32_t i = 0; i < fileCount; i++) {
+            const uint64_t hash = reader.ReadUInt64();
+            (*hashes)[hash] = reader.ReadString();
+        }
+
+        const uint32_t entryCount = reader.ReadUInt32();
+        entries->Entries.reserve(entryCount);
+        for (uint32_t i = 0; i < entryCount; i++) {
+            const uint64_t hash = reader.ReadUInt64();
+            ArchiveEntry entry;
+            entry.Index = reader.ReadUInt64();
+            entry.Offset = reader.ReadUInt64();
+            entry.CompressedSize = reader.ReadUInt64();
+            entry.Size = reader.ReadUInt64();
+            entry.CompressionMethod = reader.ReadUInt16();
+            entry.Encrypted = reader.ReadUByte() != 0;
+            entries->Entries[hash] = entry;
+        }
+
+        const uint32_t sidecarPathCount = reader.ReadUInt32();
+        sidecarPaths.reserve(sidecarPathCount);
+        for (uint32_t i = 0; i < sidecarPathCount; i++) {
+            const uint64_t hash = reader.ReadUInt64();
+            sidecarPaths[hash] = reader.ReadString();
+        }
+
+        const uint32_t sidecarCount = reader.ReadUInt32();
+        sidecars.reserve(sidecarCount);
+        for (uint32_t i = 0; i < sidecarCount; i++) {
+            const uint64_t hash = reader.ReadUInt64();
+            ResourceSidecar sidecar;
+            sidecar.Format = reader.ReadUInt32();
+            sidecar.ResourceVersion = reader.ReadInt32();
+            sidecar.Path = reader.ReadString();
+            sidecar.Type = reader.ReadString();
+            sidecars[hash] = std::move(sidecar);
+        }
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Ignoring invalid index cache for archive {}: {}", GetPath(), e.what());
+        return false;
+    }
+
+    ResetDirectoryTree();
+    mHashes = hashes;
+    mCachedEntryTable = std::move(entries);
+    mSidecarPaths = std::move(sidecarPaths);
+    mSidecars = std::move(sidecars);
+
+    return true;
+}
+
+void Archive::WriteIndexCache() {
+    uint64_t archiveSize;
+    int64_t archiveTime;
+    uint64_t checksum;
+    if (!CanCacheIndex() || !GetIndexCacheKey(archiveSize, archiveTime, checksum)) {
+        return;
+    }
+
+    auto writer = BinaryWriter(std::make_shared<MemoryStream>());
+    writer.SetEndianness(Endianness::Little);
+    writer.Write(INDEX_CACHE_MAGIC);
+    writer.Write(INDEX_CACHE_VERSION);
+    writer.Write(archiveSize);
+    writer.Write(archiveTime);
+    writer.Write(checksum);
+
+    writer.Write(static_cast<uint32_t>(mHashes->size()));
+    for (const auto& [hash, filePath] : *mHashes) {
+        writer.Write(hash);
+        writer.Write(filePath);
+    }
+
+    const auto entries = GetEntryTable();
+    writer.Write(static_cast<uint32_t>(entries->Entries.size()));
+    for (const auto& [hash, entry] : entries->Entries) {
+        writer.Write(hash);
+        writer.Write(entry.Index);
+        writer.Write(entry.Offset);
+        writer.Write(entry.CompressedSize);
+        writer.Write(entry.Size);
+        writer.Write(entry.CompressionMethod);
+        writer.Write(static_cast<uint8_t>(entry.Encrypted));
+    }
+
+    writer.Write(static_cast<uint32_t>(mSidecarPaths.size()));
+    for (const auto& [hash, metaPath] : mSidecarPaths) {
+        writer.Write(hash);
+        writer.Write(metaPath);
+    }
+
+    writer.Write(static_cast<uint32_t>(mSidecars.size()));
+    for (const auto& [hash, sidecar] : mSidecars) {
+        writer.Write(hash);
+        writer.Write(sidecar.Format);
+        writer.Write(sidecar.ResourceVersion);
+        writer.Write(sidecar.Path);
+        writer.Write(sidecar.Type);
+    }
+
+    // Written under a temporary name first, so a crash halfway through never leaves a truncated cache behind.
+    const std::string tempPath = GetIndexCachePath() + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        const auto buffer = writer.ToVector();
+        file.write(buffer.data(), buffer.size());
+        if (!file.good()) {
+            SPDLOG_WARN("Failed to write index cache for archive {}", GetPath());
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, GetIndexCachePath(), error);
+    if (error) {
+        SPDLOG_WARN("Failed to write index cache for archive {}: {}", GetPath(), error.message());
+        std::filesystem::remove(tempPath, error);
+    }
 }
 
 std::shared_ptr<File> Archive::LoadFile(uint64_t hash) {
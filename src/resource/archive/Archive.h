@@ -4,7 +4,9 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include "utils/binarytools/BinaryReader.h"
+#include "resource/archive/DirectoryTree.h"
 
 namespace tinyxml2 {
 class XMLDocument;
@@ -16,6 +18,35 @@ namespace Ship {
 
 struct File;
 struct ResourceInitData;
+class MappedFile;
+
+// Contents of a .meta sidecar file, parsed when the archive is mounted.
+struct ResourceSidecar {
+    std::string Path;
+    std::string Type;
+    int32_t ResourceVersion;
+    uint32_t Format;
+};
+
+// Where a file lives inside its archive, recorded while indexing so loads can skip looking it up by name. Which fields
+// are meaningful is up to the archive type that filled it in.
+struct ArchiveEntry {
+    uint64_t Index;
+    uint64_t Offset;
+    uint64_t CompressedSize;
+    uint64_t Size;
+    uint16_t CompressionMethod;
+    bool Encrypted;
+};
+
+// The entries of an archive, together with the mapping their locations point into for archives that read straight
+// from one. Tables are never changed once published, re-indexing an archive publishes a new one, so a load that took
+// a table keeps a consistent view of it even while the archive is being rewritten.
+struct ArchiveEntryTable {
+    // Keyed by the hash of the entry name, so .meta files have entries of their own.
+    std::unordered_map<uint64_t, ArchiveEntry> Entries;
+    std::shared_ptr<MappedFile> Mapping;
+};
 
 class Archive : public std::enable_shared_from_this<Archive> {
     friend class ArchiveManager;
@@ -31,10 +62,18 @@ class Archive : public std::enable_shared_from_this<Archive> {
 
     virtual std::shared_ptr<File> LoadFile(const std::string& filePath) = 0;
     virtual std::shared_ptr<File> LoadFile(uint64_t hash) = 0;
+    // Loads a file using the location recorded while indexing. The entry has to be from the given table. Archives that
+    // don't record entries load by path.
+    virtual std::shared_ptr<File> LoadFile(const std::string& filePath, const ArchiveEntryTable& entries,
+                                           const ArchiveEntry& entry);
     std::shared_ptr<std::unordered_map<uint64_t, std::string>> ListFiles();
     std::shared_ptr<std::unordered_map<uint64_t, std::string>> ListFiles(const std::string& filter);
     bool HasFile(const std::string& filePath);
     bool HasFile(uint64_t hash);
+    // Returns the table currently published, never nullptr. Entries found in it stay valid for as long as it's held.
+    std::shared_ptr<const ArchiveEntryTable> GetEntryTable();
+    // Returns the sidecar for the resource with the given path hash, or nullptr if it doesn't have one.
+    const ResourceSidecar* GetResourceSidecar(uint64_t hash);
     bool HasGameVersion();
     uint32_t GetGameVersion();
     const std::string& GetPath();
@@ -43,17 +82,55 @@ class Archive : public std::enable_shared_from_this<Archive> {
     virtual bool Open() = 0;
     virtual bool Close() = 0;
     virtual bool WriteFile(const std::string& filename, const std::vector<uint8_t>& data) = 0;
+    // Groups writes, so archives that have to be rewritten as a whole are only rewritten once per commit. Files written
+    // in between only show up in the archive once CommitWrite succeeds, and AbortWrite drops them. Archives that write
+    // files in place don't need to do anything here.
+    virtual bool BeginWrite();
+    virtual bool CommitWrite();
+    virtual void AbortWrite();
 
   protected:
+    // Whether the file table built by Open() is complete enough to be written to the index cache. Checked after Open().
+    virtual bool CanCacheIndex();
+    // True while Open() runs if the file table was already filled in from the index cache, in which case Open() only
+    // has to open the archive and must not enumerate it again.
+    bool IsIndexCached();
     void SetLoaded(bool isLoaded);
     void SetGameVersion(uint32_t gameVersion);
     void IndexFile(const std::string& filePath);
+    // Indexes the path and records its entry in the table, which is published with SetEntryTable once it's complete.
+    void IndexFile(const std::string& filePath, const ArchiveEntry& entry, ArchiveEntryTable& entries);
+    // Returns an empty table for Open() to fill in, or while the index is cached, the table read from the cache.
+    std::shared_ptr<ArchiveEntryTable> CreateEntryTable();
+    void SetEntryTable(std::shared_ptr<const ArchiveEntryTable> entries);
+    void IndexSidecars();
 
   private:
+    // Records the .meta file of a resource, and indexes the resource path it belongs to.
+    void IndexSidecarPath(const std::string& metaPath);
+    void AddFilePath(const std::string& filePath, uint64_t hash);
+    // Called whenever the file table changes, the tree is rebuilt by the next filtered ListFiles call.
+    void ResetDirectoryTree();
+    std::string GetIndexCachePath();
+    bool GetIndexCacheKey(uint64_t& archiveSize, int64_t& archiveTime, uint64_t& checksum);
+    bool ReadIndexCache();
+    void WriteIndexCache();
+
     bool mIsLoaded;
+    bool mIndexCached;
     bool mHasGameVersion;
     uint32_t mGameVersion;
     std::string mPath;
     std::shared_ptr<std::unordered_map<uint64_t, std::string>> mHashes;
+    std::shared_ptr<const ArchiveEntryTable> mEntryTable;
+    std::shared_mutex mEntryTableMutex;
+    // Read from the index cache before Open(), which takes it through CreateEntryTable.
+    std::shared_ptr<ArchiveEntryTable> mCachedEntryTable;
+    // Path hash of the resource -> path of its .meta file, collected while indexing.
+    std::unordered_map<uint64_t, std::string> mSidecarPaths;
+    std::unordered_map<uint64_t, ResourceSidecar> mSidecars;
+    // Paths point into mHashes.
+    std::unique_ptr<DirectoryTree> mDirectoryTree;
+    std::mutex mDirectoryTreeMutex;
 };
 } // namespace Ship
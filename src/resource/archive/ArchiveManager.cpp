@@ -1,8 +1,14 @@
 #include "ArchiveManager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <thread>
 #include "spdlog/spdlog.h"
 
+// Pulls in the thread pool with the same configuration the resource manager uses.
+#include "resource/ResourceManager.h"
+#include "Context.h"
 #include "resource/archive/Archive.h"
 #ifndef EXCLUDE_MPQ_SUPPORT
 #include "resource/archive/OtrArchive.h"
@@ -24,12 +30,48 @@ void ArchiveManager::Init(const std::vector<std::string>& archivePaths) {
 void ArchiveManager::Init(const std::vector<std::string>& archivePaths,
                           const std::unordered_set<uint32_t>& validGameVersions) {
     mValidGameVersions = validGameVersions;
-    auto archives = GetArchiveListInPaths(archivePaths);
+
+    std::vector<std::shared_ptr<Archive>> archives;
+    for (const auto& archivePath : GetArchiveListInPaths(archivePaths)) {
+        archives.push_back(CreateArchive(archivePath));
+    }
+
+    // Archives are opened and indexed in parallel, but added in the order they were found so overrides don't change.
+    LoadArchives(archives);
     for (const auto& archive : archives) {
-        AddArchive(archive);
+        MountArchive(archive);
     }
 }
 
+void ArchiveManager::LoadArchives(const std::vector<std::shared_ptr<Archive>>& archives) {
+    const auto start = std::chrono::steady_clock::now();
+
+    auto loadArchive = [&archives](size_t i) {
+        const auto archiveStart = std::chrono::steady_clock::now();
+        archives[i]->Load();
+        SPDLOG_INFO("Loaded archive {} in {:.2f}ms", archives[i]->GetPath(),
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - archiveStart).count());
+    };
+
+    const size_t threadCount =
+        std::min<size_t>(archives.size(), std::max<size_t>(1, std::thread::hardware_concurrency()));
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < archives.size(); i++) {
+            loadArchive(i);
+        }
+    } else {
+        // The resource manager's pool doesn't exist yet while archives are mounted, this one only lives for the load.
+        BS::thread_pool threadPool(static_cast<BS::concurrency_t>(threadCount));
+        auto futures = threadPool.submit_loop<size_t>(0, archives.size(), loadArchive, archives.size());
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    SPDLOG_INFO("Loaded {} archives in {:.2f}ms", archives.size(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
 ArchiveManager::~ArchiveManager() {
     SPDLOG_TRACE("destruct archive manager");
     SetArchives(nullptr);
@@ -48,12 +90,22 @@ std::shared_ptr<File> ArchiveManager::LoadFile(const std::string& filePath) {
 }
 
 std::shared_ptr<File> ArchiveManager::LoadFile(uint64_t hash) {
-    auto archive = mFileToArchive[hash];
-    if (archive == nullptr) {
+    // Loads run on many threads at once, so this must not insert into the map like operator[] would.
+    auto file = mFileToArchive.find(hash);
+    if (file == mFileToArchive.end() || file->second.Parent == nullptr) {
         return nullptr;
     }
 
-    return archive->LoadFile(hash);
+    // With a recorded entry the archive can read the file directly, without resolving the path again. The table is
+    // held for the whole load, so the entry and the data it points to stay consistent even if the archive is rewritten.
+    const auto& [archive, path] = file->second;
+    const auto entries = archive->GetEntryTable();
+    auto entry = entries->Entries.find(hash);
+    if (entry != entries->Entries.end()) {
+        return archive->LoadFile(*path, *entries, entry->second);
+    }
+
+    return archive->LoadFile(*path);
 }
 
 bool ArchiveManager::HasFile(const std::string& filePath) {
@@ -65,7 +117,8 @@ bool ArchiveManager::HasFile(uint64_t hash) {
 }
 
 std::shared_ptr<Archive> ArchiveManager::GetArchiveFromFile(const std::string& filePath) {
-    return mFileToArchive[CRC64(filePath.c_str())];
+    auto file = mFileToArchive.find(CRC64(filePath.c_str()));
+    return file != mFileToArchive.end() ? file->second.Parent : nullptr;
 }
 
 std::shared_ptr<std::vector<std::string>> ArchiveManager::ListFiles(const std::string& searchMask) {
@@ -79,43 +132,37 @@ std::shared_ptr<std::vector<std::string>> ArchiveManager::ListFiles(const std::s
 std::shared_ptr<std::vector<std::string>> ArchiveManager::ListFiles(const std::list<std::string>& includes,
                                                                     const std::list<std::string>& excludes) {
     auto list = std::make_shared<std::vector<std::string>>();
-    for (const auto& [hash, path] : mHashes) {
-        if (includes.empty() && excludes.empty()) {
-            list->push_back(path);
-            continue;
-        }
-        bool includeMatch = includes.empty();
-        if (!includes.empty()) {
-            for (std::string filter : includes) {
-                if (glob_match(filter.c_str(), path.c_str())) {
-                    includeMatch = true;
-                    break;
-                }
+    auto addFile = [&list, &excludes](const std::string& path) {
+        for (const std::string& filter : excludes) {
+            if (glob_match(filter.c_str(), path.c_str())) {
+                return;
             }
         }
-        bool excludeMatch = false;
-        if (!excludes.empty()) {
-            for (std::string filter : excludes) {
-                if (glob_match(filter.c_str(), path.c_str())) {
-                    excludeMatch = true;
-                    break;
-                }
+        list->push_back(path);
+    };
+
+    // Each include only visits the part of the directory tree its literal prefix leads to.
+    if (includes.size() <= 1) {
+        mDirectoryTree.MatchFiles(includes.empty() ? "*" : includes.front(),
+                                  [&addFile](uint64_t hash, const std::string& path) { addFile(path); });
+        return list;
+    }
+
+    // A file can match several includes, but is only listed once.
+    std::unordered_set<uint64_t> matched;
+    for (const std::string& filter : includes) {
+        mDirectoryTree.MatchFiles(filter, [&addFile, &matched](uint64_t hash, const std::string& path) {
+            if (matched.insert(hash).second) {
+                addFile(path);
             }
-        }
-        if (includeMatch && !excludeMatch) {
-            list->push_back(path);
-        }
+        });
     }
     return list;
 }
 
 std::shared_ptr<std::vector<std::string>> ArchiveManager::ListDirectories(const std::string& searchMask) {
     auto list = std::make_shared<std::vector<std::string>>();
-    for (const std::string& dir : mDirectories) {
-        if (glob_match(searchMask.c_str(), dir.c_str())) {
-            list->push_back(dir);
-        }
-    }
+    mDirectoryTree.MatchDirectories(searchMask, [&list](const std::string& dir) { list->push_back(dir); });
     return list;
 }
 
@@ -142,11 +189,15 @@ void ArchiveManager::ResetVirtualFileSystem() {
     mArchives.clear();
     mGameVersions.clear();
     mHashes.clear();
+    mDirectoryTree.Clear();
     mFileToArchive.clear();
+    mOverriddenFiles.clear();
     for (const auto& archive : archives) {
         archive->Unload();
-        archive->Load();
-        AddArchive(archive);
+    }
+    LoadArchives(archives);
+    for (const auto& archive : archives) {
+        MountArchive(archive);
     }
 }
 
@@ -160,16 +211,21 @@ bool ArchiveManager::WriteFile(std::shared_ptr<Archive> archive, const std::stri
 }
 
 size_t ArchiveManager::RemoveArchive(const std::string& path) {
-    for (size_t i = 0; i < mArchives.size(); i++) {
-        if (path == mArchives[i]->GetPath()) {
-            mArchives[i]->Unload();
-            mArchives.erase(mArchives.begin() + i);
-            ResetVirtualFileSystem();
-            return 1;
-        }
+    auto archiveFind =
+        std::find_if(mArchives.begin(), mArchives.end(),
+                     [&path](const std::shared_ptr<Archive>& archive) { return archive->GetPath() == path; });
+    if (archiveFind == mArchives.end()) {
+        return 0;
     }
 
-    return 0;
+    // Only the files this archive provided change, everything else keeps resolving to the same archive.
+    auto archive = *archiveFind;
+    mArchives.erase(archiveFind);
+    const auto changedFiles = UnmountArchive(archive);
+    archive->Unload();
+    DirtyResources(changedFiles);
+
+    return 1;
 }
 
 size_t ArchiveManager::RemoveArchive(std::shared_ptr<Archive> archive) {
@@ -193,6 +249,35 @@ const std::string* ArchiveManager::HashToString(uint64_t hash) const {
     return it != mHashes.end() ? &it->second : nullptr;
 }
 
+const ResourceSidecar* ArchiveManager::GetResourceSidecar(const std::string& filePath) {
+    const uint64_t hash = CRC64(filePath.c_str());
+    auto file = mFileToArchive.find(hash);
+    if (file == mFileToArchive.end() || file->second.Parent == nullptr) {
+        return nullptr;
+    }
+
+    auto sidecar = file->second.Parent->GetResourceSidecar(hash);
+    if (sidecar != nullptr) {
+        return sidecar;
+    }
+
+    // The .meta file resolves on its own, so an archive that only overrides the raw file keeps the sidecar of the
+    // highest priority archive that has one.
+    auto overridden = mOverriddenFiles.find(hash);
+    if (overridden == mOverriddenFiles.end()) {
+        return nullptr;
+    }
+
+    for (auto entry = overridden->second.rbegin(); entry != overridden->second.rend(); ++entry) {
+        sidecar = entry->Parent->GetResourceSidecar(hash);
+        if (sidecar != nullptr) {
+            return sidecar;
+        }
+    }
+
+    return nullptr;
+}
+
 std::vector<std::string> ArchiveManager::GetArchiveListInPaths(const std::vector<std::string>& archivePaths) {
     std::vector<std::string> fileList = {};
 
@@ -221,6 +306,12 @@ std::vector<std::string> ArchiveManager::GetArchiveListInPaths(const std::vector
 }
 
 std::shared_ptr<Archive> ArchiveManager::AddArchive(const std::string& archivePath) {
+    auto archive = CreateArchive(archivePath);
+    archive->Load();
+    return AddArchive(archive);
+}
+
+std::shared_ptr<Archive> ArchiveManager::CreateArchive(const std::string& archivePath) {
     const std::filesystem::path path = archivePath;
     const std::string extension = path.extension().string();
     std::shared_ptr<Archive> archive = nullptr;
@@ -241,20 +332,35 @@ std::shared_ptr<Archive> ArchiveManager::AddArchive(const std::string& archivePa
         archive = std::make_shared<O2rArchive>(archivePath);
     }
 
-    archive->Load();
-    return AddArchive(archive);
+    return archive;
 }
 
 std::shared_ptr<Archive> ArchiveManager::AddArchive(std::shared_ptr<Archive> archive) {
+    if (!MountArchive(archive)) {
+        return nullptr;
+    }
+
+    // Cached versions of these files came from an archive it now overrides, or failed to load before it was added.
+    std::vector<std::string> changedFiles;
+    changedFiles.reserve(archive->ListFiles()->size());
+    for (const auto& [hash, filename] : *archive->ListFiles()) {
+        changedFiles.push_back(filename);
+    }
+    DirtyResources(changedFiles);
+
+    return archive;
+}
+
+bool ArchiveManager::MountArchive(std::shared_ptr<Archive> archive) {
     if (!archive->IsLoaded()) {
         SPDLOG_WARN("Attempting to add unloaded Archive at {} to Archive Manager", archive->GetPath());
-        return nullptr;
+        return false;
     }
 
     if (!mValidGameVersions.empty() && !mValidGameVersions.contains(archive->GetGameVersion())) {
         SPDLOG_WARN("Attempting to add Archive at {} with invalid Game Version {} to Archive Manager",
                     archive->GetPath(), archive->GetGameVersion());
-        return nullptr;
+        return false;
     }
 
     SPDLOG_INFO("Adding Archive {} to Archive Manager", archive->GetPath());
@@ -263,18 +369,82 @@ std::shared_ptr<Archive> ArchiveManager::AddArchive(std::shared_ptr<Archive> arc
     if (archive->HasGameVersion()) {
         mGameVersions.push_back(archive->GetGameVersion());
     }
+
+    // The new archive has the highest priority, so it goes on top of every file it provides.
     const auto fileList = archive->ListFiles();
-    for (auto& [hash, filename] : *fileList.get()) {
-        mHashes[hash] = filename;
-        mFileToArchive[hash] = archive;
-
-        size_t lastSlash = filename.find_last_of('/');
-        if (lastSlash != std::string::npos) {
-            std::string dir = filename.substr(0, lastSlash);
-            mDirectories.insert(dir);
+    for (const auto& [hash, filename] : *fileList) {
+        auto [file, inserted] = mFileToArchive.try_emplace(hash);
+        auto& path = mHashes[hash];
+        if (inserted) {
+            path = filename;
+            mDirectoryTree.AddFile(path, hash);
+        } else {
+            mOverriddenFiles[hash].push_back(file->second);
         }
+        file->second = { archive, &path };
     }
-    return archive;
+
+    return true;
+}
+
+std::vector<std::string> ArchiveManager::UnmountArchive(std::shared_ptr<Archive> archive) {
+    std::vector<std::string> changedFiles;
+
+    if (archive->HasGameVersion()) {
+        auto gameVersion = std::find(mGameVersions.begin(), mGameVersions.end(), archive->GetGameVersion());
+        if (gameVersion != mGameVersions.end()) {
+            mGameVersions.erase(gameVersion);
+        }
+    }
+
+    const auto fileList = archive->ListFiles();
+    for (const auto& [hash, filename] : *fileList) {
+        auto file = mFileToArchive.find(hash);
+        if (file == mFileToArchive.end()) {
+            continue;
+        }
+
+        auto overridden = mOverriddenFiles.find(hash);
+        if (file->second.Parent != archive) {
+            // Something above this archive provides the file, it only has to be taken out of the stack.
+            if (overridden != mOverriddenFiles.end()) {
+                auto& stack = overridden->second;
+                auto isFromArchive = [&archive](const ArchiveFileEntry& entry) { return entry.Parent == archive; };
+                stack.erase(std::remove_if(stack.begin(), stack.end(), isFromArchive), stack.end());
+                if (stack.empty()) {
+                    mOverriddenFiles.erase(overridden);
+                }
+            }
+            continue;
+        }
+
+        changedFiles.push_back(filename);
+        if (overridden == mOverriddenFiles.end()) {
+            mFileToArchive.erase(file);
+            mDirectoryTree.RemoveFile(filename);
+            mHashes.erase(hash);
+            continue;
+        }
+
+        // The archive it overrode takes over.
+        file->second = overridden->second.back();
+        overridden->second.pop_back();
+        if (overridden->second.empty()) {
+            mOverriddenFiles.erase(overridden);
+        }
+    }
+
+    return changedFiles;
+}
+
+void ArchiveManager::DirtyResources(const std::vector<std::string>& filePaths) {
+    auto context = Context::GetInstance();
+    auto resourceManager = context != nullptr ? context->GetResourceManager() : nullptr;
+    if (resourceManager == nullptr || filePaths.empty()) {
+        return;
+    }
+
+    resourceManager->DirtyResources(filePaths);
 }
 
 bool ArchiveManager::IsGameVersionValid(uint32_t gameVersion) {
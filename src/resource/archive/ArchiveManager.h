@@ -8,11 +8,21 @@
 #include <unordered_set>
 #include <stdint.h>
 #include "resource/File.h"
+#include "resource/archive/DirectoryTree.h"
 
 namespace Ship {
 struct File;
+struct ResourceSidecar;
 class Archive;
 
+// What the file table knows about a path: the archive providing it. Where the file is in that archive is looked up
+// in the archive's current entry table on every load, the table changes when the archive is rewritten.
+struct ArchiveFileEntry {
+    std::shared_ptr<Archive> Parent;
+    // Points into the manager's own table, valid until the archive is unmounted.
+    const std::string* Path;
+};
+
 class ArchiveManager {
   public:
     ArchiveManager();
@@ -41,10 +51,21 @@ class ArchiveManager {
     std::shared_ptr<std::vector<std::string>> ListDirectories(const std::string& searchMask = "");
     std::vector<uint32_t> GetGameVersions();
     const std::string* HashToString(uint64_t hash) const;
+    // Sidecar of the resource from the highest priority archive that has one, or nullptr if none does.
+    const ResourceSidecar* GetResourceSidecar(const std::string& filePath);
     bool IsGameVersionValid(uint32_t gameVersion);
 
   protected:
     static std::vector<std::string> GetArchiveListInPaths(const std::vector<std::string>& archivePaths);
+    // Creates the archive type matching the path's extension, without loading it.
+    static std::shared_ptr<Archive> CreateArchive(const std::string& archivePath);
+    // Loads all of the archives concurrently. Adding them to the file table is left to the caller, in priority order.
+    static void LoadArchives(const std::vector<std::shared_ptr<Archive>>& archives);
+    // Puts a loaded archive on top of the override order. Doesn't touch cached resources.
+    bool MountArchive(std::shared_ptr<Archive> archive);
+    // Takes the archive out of the override order and returns the paths that now resolve differently.
+    std::vector<std::string> UnmountArchive(std::shared_ptr<Archive> archive);
+    void DirtyResources(const std::vector<std::string>& filePaths);
     void AddGameVersion(uint32_t newGameVersion);
     void ResetVirtualFileSystem();
 
@@ -53,7 +74,11 @@ class ArchiveManager {
     std::vector<uint32_t> mGameVersions;
     std::unordered_set<uint32_t> mValidGameVersions;
     std::unordered_map<uint64_t, std::string> mHashes;
-    std::unordered_set<std::string> mDirectories;
-    std::unordered_map<uint64_t, std::shared_ptr<Archive>> mFileToArchive;
+    // Paths point into mHashes.
+    DirectoryTree mDirectoryTree;
+    // The archive that provides each file, the one with the highest priority.
+    std::unordered_map<uint64_t, ArchiveFileEntry> mFileToArchive;
+    // Files provided by more than one archive. The ones overridden by mFileToArchive's entry, lowest priority first.
+    std::unordered_map<uint64_t, std::vector<ArchiveFileEntry>> mOverriddenFiles;
 };
 } // namespace Ship
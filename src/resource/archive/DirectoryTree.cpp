@@ -0,0 +1,178 @@
+#include "DirectoryTree.h"
+
+#include <vector>
+#include "utils/glob.h"
+
+namespace Ship {
+DirectoryTree::DirectoryTree() : mRoot(std::make_unique<Node>()) {
+}
+
+void DirectoryTree::AddFile(const std::string& filePath, uint64_t hash) {
+    const std::string_view path(filePath);
+    std::vector<Node*> nodes = { mRoot.get() };
+
+    size_t start = 0;
+    for (size_t slash = path.find('/'); slash != std::string_view::npos; slash = path.find('/', start)) {
+        Node* parent = nodes.back();
+        const std::string name(path.substr(start, slash - start));
+        auto& child = parent->Directories[name];
+        if (child == nullptr) {
+            child = std::make_unique<Node>();
+            child->Path = parent == mRoot.get() ? name : parent->Path + "/" + name;
+        }
+        nodes.push_back(child.get());
+        start = slash + 1;
+    }
+
+    // The name is a view into the path, so a re-added file has to take the new string's view as well.
+    auto& files = nodes.back()->Files;
+    const std::string_view name = path.substr(start);
+    const bool replaced = files.erase(name) > 0;
+    files.emplace(name, std::make_pair(hash, &filePath));
+
+    if (!replaced) {
+        for (auto node : nodes) {
+            node->FileCount++;
+        }
+    }
+}
+
+void DirectoryTree::RemoveFile(const std::string& filePath) {
+    const std::string_view path(filePath);
+    std::vector<std::pair<Node*, std::string_view>> nodes = { { mRoot.get(), {} } };
+
+    size_t start = 0;
+    for (size_t slash = path.find('/'); slash != std::string_view::npos; slash = path.find('/', start)) {
+        const std::string_view name = path.substr(start, slash - start);
+        auto child = nodes.back().first->Directories.find(std::string(name));
+        if (child == nodes.back().first->Directories.end()) {
+            return;
+        }
+        nodes.push_back({ child->second.get(), name });
+        start = slash + 1;
+    }
+
+    if (nodes.back().first->Files.erase(path.substr(start)) == 0) {
+        return;
+    }
+
+    for (auto& [node, name] : nodes) {
+        node->FileCount--;
+    }
+
+    // Drop the highest directory that's now empty, which takes everything below it along.
+    for (size_t i = 1; i < nodes.size(); i++) {
+        if (nodes[i].first->FileCount == 0) {
+            nodes[i - 1].first->Directories.erase(std::string(nodes[i].second));
+            break;
+        }
+    }
+}
+
+void DirectoryTree::Clear() {
+    mRoot = std::make_unique<Node>();
+}
+
+size_t DirectoryTree::GetFileCount() const {
+    return mRoot->FileCount;
+}
+
+const DirectoryTree::Node* DirectoryTree::FindPrefixNode(const std::string& pattern, std::string_view& partialName,
+                                                         bool& hasWildcard) const {
+    const size_t wildcard = pattern.find_first_of("*?[\\");
+    hasWildcard = wildcard != std::string::npos;
+    const std::string_view prefix = std::string_view(pattern).substr(0, wildcard);
+
+    const Node* node = mRoot.get();
+    size_t start = 0;
+    for (size_t slash = prefix.find('/'); slash != std::string_view::npos; slash = prefix.find('/', start)) {
+        auto child = node->Directories.find(std::string(prefix.substr(start, slash - start)));
+        if (child == node->Directories.end()) {
+            return nullptr;
+        }
+        node = child->second.get();
+        start = slash + 1;
+    }
+
+    partialName = prefix.substr(start);
+    return node;
+}
+
+void DirectoryTree::MatchFiles(const std::string& pattern, const FileCallback& callback) const {
+    std::string_view partialName;
+    bool hasWildcard;
+    const Node* node = FindPrefixNode(pattern, partialName, hasWildcard);
+    if (node == nullptr) {
+        return;
+    }
+
+    if (!hasWildcard) {
+        auto file = node->Files.find(partialName);
+        if (file != node->Files.end()) {
+            callback(file->second.first, *file->second.second);
+        }
+        return;
+    }
+
+    // * also matches slashes, so a pattern that is a literal prefix followed by a single * matches everything below it.
+    const size_t prefixLength = partialName.data() + partialName.size() - pattern.data();
+    const bool matchesAll = pattern.size() == prefixLength + 1 && pattern.back() == '*';
+    auto visit = [&pattern, &callback, matchesAll](uint64_t hash, const std::string& filePath) {
+        if (matchesAll || glob_match(pattern.c_str(), filePath.c_str())) {
+            callback(hash, filePath);
+        }
+    };
+
+    for (const auto& [name, file] : node->Files) {
+        if (name.starts_with(partialName)) {
+            visit(file.first, *file.second);
+        }
+    }
+    for (const auto& [name, child] : node->Directories) {
+        if (name.starts_with(partialName)) {
+            VisitFiles(*child, visit);
+        }
+    }
+}
+
+void DirectoryTree::MatchDirectories(const std::string& pattern, const DirectoryCallback& callback) const {
+    std::string_view partialName;
+    bool hasWildcard;
+    const Node* node = FindPrefixNode(pattern, partialName, hasWildcard);
+    if (node == nullptr) {
+        return;
+    }
+
+    // Matches have to start with the literal prefix, which already goes past the path of the directory it leads to, so
+    // only the directories below it are checked.
+    auto visit = [&pattern, &callback](const std::string& directoryPath) {
+        if (glob_match(pattern.c_str(), directoryPath.c_str())) {
+            callback(directoryPath);
+        }
+    };
+
+    for (const auto& [name, child] : node->Directories) {
+        if (name.starts_with(partialName)) {
+            VisitDirectories(*child, visit);
+        }
+    }
+}
+
+void DirectoryTree::VisitFiles(const Node& node, const FileCallback& callback) {
+    for (const auto& [name, file] : node.Files) {
+        callback(file.first, *file.second);
+    }
+    for (const auto& [name, child] : node.Directories) {
+        VisitFiles(*child, callback);
+    }
+}
+
+void DirectoryTree::VisitDirectories(const Node& node, const DirectoryCallback& callback) {
+    if (!node.Files.empty()) {
+        callback(node.Path);
+    }
+    for (const auto& [name, child] : node.Directories) {
+        VisitDirectories(*child, callback);
+    }
+}
+} // namespace Ship
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Ship {
+
+// Index of file paths by directory, so that glob queries only visit the part of the tree their literal prefix allows.
+// Queries that start with a wildcard still visit every file. Paths are not copied, the strings passed to AddFile
+// must stay alive and unchanged until they're removed or the tree is cleared. Each file keeps the path hash it was
+// added with, so callers get it back without hashing the path again.
+class DirectoryTree {
+  public:
+    DirectoryTree();
+
+    using FileCallback = std::function<void(uint64_t hash, const std::string& filePath)>;
+    using DirectoryCallback = std::function<void(const std::string& directoryPath)>;
+
+    void AddFile(const std::string& filePath, uint64_t hash);
+    void RemoveFile(const std::string& filePath);
+    void Clear();
+    size_t GetFileCount() const;
+
+    // Calls the callback for every file whose path matches the glob pattern, with the same rules as glob_match.
+    void MatchFiles(const std::string& pattern, const FileCallback& callback) const;
+    // Calls the callback for every directory that directly contains a file and whose path matches the glob pattern.
+    void MatchDirectories(const std::string& pattern, const DirectoryCallback& callback) const;
+
+  private:
+    struct Node {
+        // Full path of the directory, without a trailing slash. Empty for the root.
+        std::string Path;
+        std::unordered_map<std::string, std::unique_ptr<Node>> Directories;
+        // Keyed by file name, which is a view into the full path.
+        std::unordered_map<std::string_view, std::pair<uint64_t, const std::string*>> Files;
+        // Files in this directory and all directories below it.
+        size_t FileCount = 0;
+    };
+
+    // Splits the pattern at its first wildcard and finds the deepest directory every match has to be in. Returns
+    // nullptr if no such directory exists. partialName is set to the rest of the literal prefix below that directory.
+    const Node* FindPrefixNode(const std::string& pattern, std::string_view& partialName, bool& hasWildcard) const;
+    static void VisitFiles(const Node& node, const FileCallback& callback);
+    static void VisitDirectories(const Node& node, const DirectoryCallback& callback);
+
+    std::unique_ptr<Node> mRoot;
+};
+} // namespace Ship
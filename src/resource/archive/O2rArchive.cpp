@@ -3,13 +3,67 @@
 #include "Context.h"
 #include "window/Window.h"
 #include "spdlog/spdlog.h"
+#include "utils/binarytools/SpanReader.h"
+#include "utils/StrHash64.h"
+#include <zlib.h>
+#include <thread>
 
 namespace Ship {
+// Never a valid zip index, so LoadZipFile goes straight to the name lookup.
+static constexpr uint64_t UNINDEXED_ZIP_ENTRY = UINT64_MAX;
+
 O2rArchive::O2rArchive(const std::string& archivePath) : Archive(archivePath) {
 }
 
 O2rArchive::~O2rArchive() {
     SPDLOG_TRACE("destruct o2rarchive: {}", GetPath());
+    CloseReadHandles();
+}
+
+std::shared_ptr<zip_t> O2rArchive::AcquireReadHandle() {
+    zip_t* handle = nullptr;
+    uint32_t generation;
+
+    {
+        const std::lock_guard<std::mutex> lock(mReadHandlesMutex);
+        generation = mReadHandleGeneration;
+        if (!mReadHandles.empty()) {
+            handle = mReadHandles.back();
+            mReadHandles.pop_back();
+        }
+    }
+
+    if (handle == nullptr) {
+        handle = zip_open(GetPath().c_str(), ZIP_RDONLY, nullptr);
+        if (handle == nullptr) {
+            SPDLOG_ERROR("Failed to open read handle for zip file \"{}\"", GetPath());
+            return nullptr;
+        }
+    }
+
+    return std::shared_ptr<zip_t>(
+        handle, [this, generation](zip_t* readHandle) { ReleaseReadHandle(readHandle, generation); });
+}
+
+void O2rArchive::ReleaseReadHandle(zip_t* handle, uint32_t generation) {
+    {
+        const std::lock_guard<std::mutex> lock(mReadHandlesMutex);
+        if (generation == mReadHandleGeneration) {
+            mReadHandles.push_back(handle);
+            return;
+        }
+    }
+
+    zip_discard(handle);
+}
+
+void O2rArchive::CloseReadHandles() {
+    const std::lock_guard<std::mutex> lock(mReadHandlesMutex);
+    for (auto handle : mReadHandles) {
+        zip_discard(handle);
+    }
+    mReadHandles.clear();
+    mReadHandleGeneration++;
 }
 
 std::shared_ptr<File> O2rArchive::LoadFile(uint64_t hash) {
@@ -19,22 +73,149 @@ std::shared_ptr<File> O2rArchive::LoadFile(uint64_t hash) {
 }
 
 std::shared_ptr<File> O2rArchive::LoadFile(const std::string& filePath) {
-    if (mZipArchive == nullptr) {
+    const auto entries = GetEntryTable();
+    auto entry = entries->Entries.find(CRC64(filePath.c_str()));
+    if (entry != entries->Entries.end()) {
+        return LoadFile(filePath, *entries, entry->second);
+    }
+
+    if (!mOpened) {
         SPDLOG_TRACE("Failed to open file {} from zip archive {}. Archive not open.", filePath, GetPath());
         return nullptr;
     }
 
-    auto zipEntryIndex = zip_name_locate(mZipArchive, filePath.c_str(), 0);
-    if (zipEntryIndex < 0) {
-        SPDLOG_TRACE("Failed to find file {} in zip archive  {}.", filePath, GetPath());
+    // Files that weren't indexed, e.g. written since the archive was opened through libzip, are looked up by name.
+    return LoadZipFile(filePath, UNINDEXED_ZIP_ENTRY);
+}
+
+std::shared_ptr<File> O2rArchive::LoadFile(const std::string& filePath, const ArchiveEntryTable& entries,
+                                           const ArchiveEntry& entry) {
+    if (!mOpened) {
+        SPDLOG_TRACE("Failed to open file {} from zip archive {}. Archive not open.", filePath, GetPath());
+        return nullptr;
+    }
+
+    // Anything other than plain stored or deflated entries is left to libzip.
+    if (entries.Mapping != nullptr && !entry.Encrypted && entry.Size <= UINT32_MAX &&
+        entry.CompressedSize <= UINT32_MAX &&
+        (entry.CompressionMethod == ZIP_CM_STORE || entry.CompressionMethod == ZIP_CM_DEFLATE)) {
+        return LoadMappedFile(filePath, entries.Mapping, entry);
+    }
+
+    return LoadZipFile(filePath, entry.Index);
+}
+
+std::shared_ptr<File> O2rArchive::LoadMappedFile(const std::string& filePath,
+                                                 const std::shared_ptr<MappedFile>& mappedFile,
+                                                 const ArchiveEntry& entry) {
+    // Views handed out below keep the mapping alive after the archive lets go of it.
+    const char* data = mappedFile->GetData();
+    const size_t size = mappedFile->GetSize();
+
+    // The local header's name and extra field can differ from the central directory's, so the data offset is only
+    // known once it's read.
+    size_t dataOffset;
+    try {
+        if (entry.Offset > size) {
+            throw std::out_of_range("Local header out of range");
+        }
+
+        SpanReader localHeader(data + entry.Offset, size - entry.Offset, Endianness::Little);
+        if (localHeader.ReadUInt32() != 0x04034B50) {
+            SPDLOG_ERROR("Invalid local header for file {} in zip archive {}.", filePath, GetPath());
+            return nullptr;
+        }
+        localHeader.Seek(22, SeekOffsetType::Current);
+        const uint16_t nameLength = localHeader.ReadUInt16();
+        const uint16_t extraLength = localHeader.ReadUInt16();
+        dataOffset = entry.Offset + localHeader.GetBaseAddress() + nameLength + extraLength;
+    } catch (const std::out_of_range& e) {
+        SPDLOG_ERROR("Invalid local header for file {} in zip archive {}.", filePath, GetPath());
         return nullptr;
     }
 
+    if (dataOffset > size || entry.CompressedSize > size - dataOffset) {
+        SPDLOG_ERROR("File {} runs past the end of zip archive {}.", filePath, GetPath());
+        return nullptr;
+    }
+
+    // Stored entries are read straight from the mapping, so the size read has to be the size checked above.
+    if (entry.CompressionMethod == ZIP_CM_STORE && entry.Size != entry.CompressedSize) {
+        SPDLOG_ERROR("Stored file {} has mismatched sizes in zip archive {}.", filePath, GetPath());
+        return nullptr;
+    }
+
+    // Filesize 0, no logging needed
+    if (entry.Size == 0) {
+        SPDLOG_TRACE("Failed to load file {}; filesize 0", filePath, GetPath());
+        return nullptr;
+    }
+
+    auto fileToLoad = std::make_shared<File>();
+
+    if (entry.CompressionMethod == ZIP_CM_STORE) {
+#ifdef _WIN32
+        // Windows can't replace a file that's still mapped, so views would keep the archive from ever being written
+        // to again. Stored entries are copied out instead, leaving the archive as the mapping's only owner.
+        fileToLoad->Buffer = std::make_shared<std::vector<char>>(data + dataOffset, data + dataOffset + entry.Size);
+#else
+        // Stored entries are handed out as views into the mapping, nothing is copied.
+        fileToLoad->View = std::shared_ptr<const char>(mappedFile, data + dataOffset);
+        fileToLoad->ViewSize = entry.Size;
+#endif
+    } else {
+        // Deflated entries are inflated straight into the final buffer.
+        fileToLoad->Buffer = std::make_shared<std::vector<char>>(entry.Size);
+
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            SPDLOG_ERROR("Failed to initialize inflate for file {} in zip archive {}.", filePath, GetPath());
+            return nullptr;
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + dataOffset));
+        stream.avail_in = static_cast<uInt>(entry.CompressedSize);
+        stream.next_out = reinterpret_cast<Bytef*>(fileToLoad->Buffer->data());
+        stream.avail_out = static_cast<uInt>(entry.Size);
+
+        const int result = inflate(&stream, Z_FINISH);
+        const uint64_t inflatedSize = stream.total_out;
+        inflateEnd(&stream);
+
+        if (result != Z_STREAM_END || inflatedSize != entry.Size) {
+            SPDLOG_ERROR("Error inflating file {} in zip archive {}.", filePath, GetPath());
+            return nullptr;
+        }
+    }
+
+    fileToLoad->IsLoaded = true;
+
+    return fileToLoad;
+}
+
+std::shared_ptr<File> O2rArchive::LoadZipFile(const std::string& filePath, uint64_t zipEntryIndex) {
+    auto zipArchive = AcquireReadHandle();
+    if (zipArchive == nullptr) {
+        return nullptr;
+    }
+
+    // The index was recorded when the archive was indexed. Only fall back to a name lookup if it no longer matches.
     struct zip_stat zipEntryStat;
     zip_stat_init(&zipEntryStat);
-    if (zip_stat_index(mZipArchive, zipEntryIndex, 0, &zipEntryStat) != 0) {
-        SPDLOG_TRACE("Failed to get entry information for file {} in zip archive  {}.", filePath, GetPath());
-        return nullptr;
+    if (zip_stat_index(zipArchive.get(), zipEntryIndex, 0, &zipEntryStat) != 0 || zipEntryStat.name == nullptr ||
+        filePath != zipEntryStat.name) {
+        auto locatedIndex = zip_name_locate(zipArchive.get(), filePath.c_str(), 0);
+        if (locatedIndex < 0) {
+            SPDLOG_TRACE("Failed to find file {} in zip archive  {}.", filePath, GetPath());
+            return nullptr;
+        }
+
+        zipEntryIndex = locatedIndex;
+        zip_stat_init(&zipEntryStat);
+        if (zip_stat_index(zipArchive.get(), zipEntryIndex, 0, &zipEntryStat) != 0) {
+            SPDLOG_TRACE("Failed to get entry information for file {} in zip archive  {}.", filePath, GetPath());
+            return nullptr;
+        }
     }
 
     // Filesize 0, no logging needed
@@ -43,7 +224,7 @@ std::shared_ptr<File> O2rArchive::LoadFile(const std::string& filePath) {
         return nullptr;
     }
 
-    struct zip_file* zipEntryFile = zip_fopen_index(mZipArchive, zipEntryIndex, 0);
+    struct zip_file* zipEntryFile = zip_fopen_index(zipArchive.get(), zipEntryIndex, 0);
     if (!zipEntryFile) {
         SPDLOG_TRACE("Failed to open file {} in zip archive  {}.", filePath, GetPath());
         return nullptr;
@@ -65,12 +246,172 @@ std::shared_ptr<File> O2rArchive::LoadFile(const std::string& filePath) {
     return fileToLoad;
 }
 
+bool O2rArchive::OpenMapped() {
+    auto mappedFile = MappedFile::Open(GetPath());
+    if (mappedFile == nullptr) {
+        return false;
+    }
+
+    // Entries loaded from the index cache were recorded from this same central directory.
+    if (IsIndexCached()) {
+        auto entries = CreateEntryTable();
+        entries->Mapping = mappedFile;
+        SetEntryTable(entries);
+        return true;
+    }
+
+    const char* data = mappedFile->GetData();
+    const size_t size = mappedFile->GetSize();
+    std::vector<std::pair<std::string, ArchiveEntry>> entries;
+
+    try {
+        // The end of central directory record sits at the very end, followed by a comment of up to 64KB.
+        constexpr size_t endRecordSize = 22;
+        if (size < endRecordSize) {
+            return false;
+        }
+
+        size_t endRecordOffset = SIZE_MAX;
+        const size_t searchEnd = size > endRecordSize + 0xFFFF ? size - endRecordSize - 0xFFFF : 0;
+        for (size_t i = size - endRecordSize + 1; i-- > searchEnd;) {
+            if (SpanReader(data + i, 4, Endianness::Little).ReadUInt32() == 0x06054B50) {
+                endRecordOffset = i;
+                break;
+            }
+        }
+        if (endRecordOffset == SIZE_MAX) {
+            return false;
+        }
+
+        SpanReader endRecord(data + endRecordOffset, size - endRecordOffset, Endianness::Little);
+        endRecord.Seek(4, SeekOffsetType::Start);
+        const uint16_t diskNumber = endRecord.ReadUInt16();
+        endRecord.Seek(4, SeekOffsetType::Current);
+        uint64_t entryCount = endRecord.ReadUInt16();
+        uint64_t directorySize = endRecord.ReadUInt32();
+        uint64_t directoryOffset = endRecord.ReadUInt32();
+
+        // Split archives aren't supported.
+        if (diskNumber != 0) {
+            return false;
+        }
+
+        // Zip64 archives keep the real values in a separate record, found through a locator right before this one.
+        if (endRecordOffset >= 20 &&
+            SpanReader(data + endRecordOffset - 20, 4, Endianness::Little).ReadUInt32() == 0x07064B50) {
+            SpanReader locator(data + endRecordOffset - 20, 20, Endianness::Little);
+            locator.Seek(8, SeekOffsetType::Start);
+            const uint64_t zip64RecordOffset = locator.ReadUInt64();
+            if (zip64RecordOffset >= size) {
+                return false;
+            }
+
+            SpanReader zip64Record(data + zip64RecordOffset, size - zip64RecordOffset, Endianness::Little);
+            if (zip64Record.ReadUInt32() != 0x06064B50) {
+                return false;
+            }
+            zip64Record.Seek(28, SeekOffsetType::Current);
+            entryCount = zip64Record.ReadUInt64();
+            directorySize = zip64Record.ReadUInt64();
+            directoryOffset = zip64Record.ReadUInt64();
+        }
+
+        if (directoryOffset > size || directorySize > size - directoryOffset) {
+            return false;
+        }
+
+        SpanReader directory(data + directoryOffset, directorySize, Endianness::Little);
+        entries.reserve(entryCount);
+        for (uint64_t i = 0; i < entryCount; i++) {
+            if (directory.ReadUInt32() != 0x02014B50) {
+                return false;
+            }
+
+            directory.Seek(4, SeekOffsetType::Current);
+            const uint16_t flags = directory.ReadUInt16();
+            ArchiveEntry entry;
+            entry.Index = i;
+            entry.CompressionMethod = directory.ReadUInt16();
+            entry.Encrypted = (flags & 1) != 0;
+            directory.Seek(8, SeekOffsetType::Current);
+            entry.CompressedSize = directory.ReadUInt32();
+            entry.Size = directory.ReadUInt32();
+            const uint16_t nameLength = directory.ReadUInt16();
+            const uint16_t extraLength = directory.ReadUInt16();
+            const uint16_t commentLength = directory.ReadUInt16();
+            directory.Seek(8, SeekOffsetType::Current);
+            entry.Offset = directory.ReadUInt32();
+
+            std::string fileName(directory.GetCurrent(), std::min<size_t>(nameLength, directory.GetRemaining()));
+            directory.Seek(nameLength, SeekOffsetType::Current);
+
+            // Values that don't fit in 32 bits are in the zip64 extra field, in this order, only when needed.
+            SpanReader extra(directory.GetCurrent(), std::min<size_t>(extraLength, directory.GetRemaining()),
+                             Endianness::Little);
+            while (extra.GetRemaining() >= 4) {
+                const uint16_t extraId = extra.ReadUInt16();
+                const uint16_t extraSize = extra.ReadUInt16();
+                if (extraId != 0x0001) {
+                    extra.Seek(extraSize, SeekOffsetType::Current);
+                    continue;
+                }
+
+                if (entry.Size == UINT32_MAX) {
+                    entry.Size = extra.ReadUInt64();
+                }
+                if (entry.CompressedSize == UINT32_MAX) {
+                    entry.CompressedSize = extra.ReadUInt64();
+                }
+                if (entry.Offset == UINT32_MAX) {
+                    entry.Offset = extra.ReadUInt64();
+                }
+                break;
+            }
+            directory.Seek(extraLength + commentLength, SeekOffsetType::Current);
+
+            // It is possible for directories to have entries in a zip
+            // file, we don't want those indexed as files in the archive
+            if (fileName.empty() || fileName.back() == '/') {
+                continue;
+            }
+
+            entries.emplace_back(std::move(fileName), entry);
+        }
+    } catch (const std::out_of_range& e) {
+        SPDLOG_WARN("Failed to read the central directory of zip file \"{}\", falling back to libzip", GetPath());
+        return false;
+    }
+
+    // The new table is only published once it's complete, loads keep using the previous one until then.
+    auto entryTable = CreateEntryTable();
+    entryTable->Entries.reserve(entries.size());
+    entryTable->Mapping = mappedFile;
+    for (const auto& [fileName, entry] : entries) {
+        IndexFile(fileName, entry, *entryTable);
+    }
+    SetEntryTable(entryTable);
+
+    return true;
+}
+
 bool O2rArchive::Open() {
+    if (OpenMapped()) {
+        mOpened = true;
+        return true;
+    }
+
     mZipArchive = zip_open(GetPath().c_str(), ZIP_CREATE, nullptr);
     if (mZipArchive == nullptr) {
         SPDLOG_ERROR("Failed to load zip file \"{}\"", GetPath());
         return false;
     }
+    mOpened = true;
+
+    auto entries = CreateEntryTable();
+    if (IsIndexCached()) {
+        SetEntryTable(entries);
+        return true;
+    }
 
     auto zipNumEntries = zip_get_num_entries(mZipArchive, 0);
     for (auto i = 0; i < zipNumEntries; i++) {
@@ -82,47 +423,153 @@ bool O2rArchive::Open() {
             continue;
         }
 
-        IndexFile(zipEntryName);
+        // Only the index is known without a stat per entry, it's enough to skip the name lookup on loads.
+        IndexFile(zipEntryName, { static_cast<uint64_t>(i), 0, 0, 0, 0, false }, *entries);
     }
+    SetEntryTable(entries);
 
     return true;
 }
 
+bool O2rArchive::CanCacheIndex() {
+    // Entries indexed through libzip only hold the zip index, the mapped reader needs the full location.
+    return GetEntryTable()->Mapping != nullptr;
+}
+
+void O2rArchive::ReleaseMapping() {
+    auto mappedEntries = GetEntryTable();
+    if (mappedEntries->Mapping == nullptr) {
+        return;
+    }
+
+    // The same entries without the mapping, loads read them through libzip.
+    auto entries = std::make_shared<ArchiveEntryTable>();
+    entries->Entries = mappedEntries->Entries;
+    SetEntryTable(entries);
+
+#ifdef _WIN32
+    // Nothing handed out holds the mapping on Windows, only loads that are reading from it right now. They're done
+    // with it shortly.
+    while (mappedEntries.use_count() > 1 || mappedEntries->Mapping.use_count() > 1) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
 bool O2rArchive::Close() {
-    if (zip_close(mZipArchive) == -1) {
+    CloseReadHandles();
+    ReleaseMapping();
+    mOpened = false;
+
+    if (mZipArchive != nullptr && zip_close(mZipArchive) == -1) {
         SPDLOG_ERROR("Failed to close zip file \"{}\"", GetPath());
         return false;
     }
+    mZipArchive = nullptr;
 
     return true;
 }
 
 bool O2rArchive::WriteFile(const std::string& filename, const std::vector<uint8_t>& data) {
-    if (!mZipArchive) {
-        SPDLOG_ERROR("Cannot write to ZIP: Archive is not open.");
-        return false;
+    {
+        const std::lock_guard<std::mutex> lock(mPendingWritesMutex);
+        if (mWriting) {
+            mPendingWrites[filename] = data;
+            return true;
+        }
     }
 
-    // Create a new zip source from the data buffer
-    zip_source_t* source = zip_source_buffer(mZipArchive, data.data(), data.size(), 0);
-    if (!source) {
-        SPDLOG_ERROR("Failed to create zip source for file \"{}\"", filename);
+    return BeginWrite() && WriteFile(filename, data) && CommitWrite();
+}
+
+bool O2rArchive::BeginWrite() {
+    const std::lock_guard<std::mutex> lock(mPendingWritesMutex);
+    if (mWriting) {
+        SPDLOG_ERROR("A write to zip file \"{}\" is already in progress", GetPath());
         return false;
     }
 
-    // Add or replace the file in the ZIP archive
-    if (zip_file_add(mZipArchive, filename.c_str(), source, ZIP_FL_ENC_UTF_8 | ZIP_FL_OVERWRITE) < 0) {
-        SPDLOG_ERROR("Failed to add file \"{}\" to ZIP", filename);
-        zip_source_free(source);
+    mWriting = true;
+    return true;
+}
+
+void O2rArchive::AbortWrite() {
+    const std::lock_guard<std::mutex> lock(mPendingWritesMutex);
+    mWriting = false;
+    mPendingWrites.clear();
+}
+
+bool O2rArchive::CommitWrite() {
+    std::map<std::string, std::vector<uint8_t>> pendingWrites;
+    {
+        const std::lock_guard<std::mutex> lock(mPendingWritesMutex);
+        if (!mWriting) {
+            SPDLOG_ERROR("Cannot commit to zip file \"{}\": No write in progress.", GetPath());
+            return false;
+        }
+        mWriting = false;
+        pendingWrites.swap(mPendingWrites);
+    }
+
+    if (pendingWrites.empty()) {
+        return true;
+    }
+
+    // Mapped archives only open libzip once something is written to them.
+    const bool wasMapped = GetEntryTable()->Mapping != nullptr;
+    if (mZipArchive == nullptr && wasMapped) {
+        mZipArchive = zip_open(GetPath().c_str(), ZIP_CREATE, nullptr);
+    }
+
+    if (!mZipArchive) {
+        SPDLOG_ERROR("Cannot write to ZIP: Archive is not open.");
         return false;
     }
-    SPDLOG_INFO("Successfully wrote file: {}", filename);
 
-    // Save changes to disk
+    // The sources point into pendingWrites, they're only read when the archive is closed below.
+    for (const auto& [filename, data] : pendingWrites) {
+        zip_source_t* source = zip_source_buffer(mZipArchive, data.data(), data.size(), 0);
+        if (!source) {
+            SPDLOG_ERROR("Failed to create zip source for file \"{}\"", filename);
+            zip_unchange_all(mZipArchive);
+            return false;
+        }
+
+        // Add or replace the file in the ZIP archive
+        if (zip_file_add(mZipArchive, filename.c_str(), source, ZIP_FL_ENC_UTF_8 | ZIP_FL_OVERWRITE) < 0) {
+            SPDLOG_ERROR("Failed to add file \"{}\" to ZIP", filename);
+            zip_source_free(source);
+            zip_unchange_all(mZipArchive);
+            return false;
+        }
+    }
+
+    // Save changes to disk. libzip writes the new archive to a temporary file next to the old one and renames it over
+    // the old one, so the archive on disk is replaced in one step and is never left half written. Loads still holding a
+    // handle keep reading the old file, and the pooled ones are dropped.
+    CloseReadHandles();
+
+    // The mapping is let go of first, Windows refuses to rename over a file that's still mapped. Loads go through
+    // libzip until the rewritten archive is mapped again.
+    ReleaseMapping();
+
     if (zip_close(mZipArchive) < 0) {
         SPDLOG_ERROR("Failed to save changes to ZIP archive.");
+        zip_unchange_all(mZipArchive);
+        if (wasMapped) {
+            OpenMapped();
+        }
         return false;
     }
+    SPDLOG_INFO("Successfully wrote {} files to zip file \"{}\"", pendingWrites.size(), GetPath());
+
+    mZipArchive = nullptr;
+
+    // Remap the rewritten archive and publish its entries. Files that are views into the old mapping keep it alive
+    // until they're released.
+    if (wasMapped && OpenMapped()) {
+        return true;
+    }
 
     // Reopen the zip file for reading
     mZipArchive = zip_open(GetPath().c_str(), ZIP_CREATE, nullptr);
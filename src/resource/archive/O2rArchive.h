@@ -2,15 +2,19 @@
 
 #undef _DLL
 
+#include <map>
 #include <string>
 #include <stdint.h>
-#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "zip.h"
 
 #include "resource/File.h"
 #include "resource/Resource.h"
 #include "resource/archive/Archive.h"
+#include "utils/filesystemtools/MappedFile.h"
 
 namespace Ship {
 struct File;
@@ -22,12 +26,48 @@ class O2rArchive final : virtual public Archive {
 
     bool Open();
     bool Close();
+    // Outside of a write transaction, every write is a transaction of its own.
     bool WriteFile(const std::string& filename, const std::vector<uint8_t>& data);
+    bool BeginWrite();
+    bool CommitWrite();
+    void AbortWrite();
 
     std::shared_ptr<File> LoadFile(const std::string& filePath);
     std::shared_ptr<File> LoadFile(uint64_t hash);
+    // Entries hold the zip index, and for mapped archives the local header offset, sizes and compression method.
+    std::shared_ptr<File> LoadFile(const std::string& filePath, const ArchiveEntryTable& entries,
+                                   const ArchiveEntry& entry);
+
+  protected:
+    bool CanCacheIndex();
 
   private:
-    zip_t* mZipArchive;
+    // Maps the archive and indexes it from its central directory. Returns false if the archive can't be mapped or
+    // uses zip features the mapped reader doesn't handle, in which case everything goes through libzip.
+    bool OpenMapped();
+    std::shared_ptr<File> LoadMappedFile(const std::string& filePath, const std::shared_ptr<MappedFile>& mappedFile,
+                                         const ArchiveEntry& entry);
+    std::shared_ptr<File> LoadZipFile(const std::string& filePath, uint64_t zipEntryIndex);
+    // Drops the archive's mapping so the file can be replaced. On Windows this waits for loads still reading from it.
+    void ReleaseMapping();
+
+    // libzip handles can't be used from several threads at once, so every load borrows a read-only handle of its own.
+    // Idle handles are kept around and reused, so the pool grows to the number of threads loading at the same time.
+    std::shared_ptr<zip_t> AcquireReadHandle();
+    void ReleaseReadHandle(zip_t* handle, uint32_t generation);
+    void CloseReadHandles();
+
+    // Only used for indexing and writing. Not opened at all when the archive is mapped, until something is written.
+    // The mapping is part of the entry table, so loads always read it together with the entries that point into it.
+    zip_t* mZipArchive = nullptr;
+    bool mOpened = false;
+    std::vector<zip_t*> mReadHandles;
+    // Bumped whenever the archive is rewritten, handles opened before that are closed instead of returned to the pool.
+    uint32_t mReadHandleGeneration = 0;
+    std::mutex mReadHandlesMutex;
+    // Files written since BeginWrite, by name. Ordered so the entries are added to the archive in a stable order.
+    std::map<std::string, std::vector<uint8_t>> mPendingWrites;
+    bool mWriting = false;
+    std::mutex mPendingWritesMutex;
 };
 } // namespace Ship
@@ -77,6 +77,10 @@ bool OtrArchive::Open() {
         return false;
     }
 
+    if (IsIndexCached()) {
+        return opened;
+    }
+
     // Generate the file list by reading the list file.
     // This can also be done via the StormLib API, but this was copied from the LUS1.x implementation in GenerateCrcMap.
     auto listFile = LoadFile("(listfile)");
@@ -30,6 +30,8 @@ class OtrArchive final : virtual public Archive {
     bool Close();
     bool WriteFile(const std::string& filename, const std::vector<uint8_t>& data);
 
+    // Entries aren't recorded for this archive type, the base class loads by path.
+    using Archive::LoadFile;
     std::shared_ptr<File> LoadFile(const std::string& filePath);
     std::shared_ptr<File> LoadFile(uint64_t hash);
 
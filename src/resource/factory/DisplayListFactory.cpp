@@ -160,49 +160,64 @@ ResourceFactoryBinaryDisplayListV0::ReadResource(std::shared_ptr<Ship::File> fil
     }
 
     auto displayList = std::make_shared<DisplayList>(initData);
-    auto reader = std::get<std::shared_ptr<Ship::BinaryReader>>(file->Reader);
-    auto ucode = (UcodeHandlers)reader->ReadInt8();
+    auto reader = file->GetSpanReader(initData->ByteOrder);
+    auto ucode = (UcodeHandlers)reader.ReadInt8();
 
     displayList->UCode = ucode;
 
-    while (reader->GetBaseAddress() % 8 != 0) {
-        reader->ReadInt8();
+    while (reader.GetBaseAddress() % 8 != 0) {
+        reader.ReadInt8();
     }
 
-    size_t idx = 0;
+    // Every 64-bit pair of words in the file becomes one Gfx, the second half of a 128-bit command included. The words
+    // are read and byte swapped in bulk into the front of the instruction storage, then widened to pointer sized words
+    // in place. Each Gfx is at least as large as the pair it's made from, so widening back to front never overwrites a
+    // pair that's still to be read.
+    const size_t pairCount = reader.GetRemaining() / 8;
+    displayList->Instructions.resize(pairCount);
+    auto* words = reinterpret_cast<char*>(displayList->Instructions.data());
+    reader.ReadArray(reinterpret_cast<uint32_t*>(words), pairCount * 2);
+
+    const int8_t endOpcode = GetEndOpcodeByUCode(ucode);
+    size_t commandCount = 0;
     while (true) {
-        Gfx command;
-        command.words.w0 = reader->ReadUInt32();
-        command.words.w1 = reader->ReadUInt32();
+        if (commandCount >= pairCount) {
+            throw std::out_of_range("Display list " + initData->Path + " has no end command");
+        }
 
-        int8_t opcode = (int8_t)(command.words.w0 >> 24);
-        bool isExpanded = opcode == G_SETTIMG_OTR_HASH || opcode == G_DL_OTR_HASH || opcode == G_VTX_OTR_HASH ||
-                          opcode == G_BRANCH_Z_OTR || opcode == G_MARKER || opcode == G_MTX_OTR;
+        uint32_t w0;
+        memcpy(&w0, words + commandCount * 8, sizeof(w0));
+        const int8_t opcode = (int8_t)(w0 >> 24);
+        const bool isExpanded = opcode == G_SETTIMG_OTR_HASH || opcode == G_DL_OTR_HASH ||
+                                opcode == G_VTX_OTR_HASH || opcode == G_BRANCH_Z_OTR || opcode == G_MARKER ||
+                                opcode == G_MTX_OTR || opcode == G_MESH_OTR_HASH || opcode == G_VTX_EXT;
 
-        // These are 128-bit commands, so read an extra 64 bits...
-        if (isExpanded) {
-#ifdef USE_GBI_TRACE
-            command.words.trace.file = initData->Path.c_str();
-            command.words.trace.idx = idx++;
-            command.words.trace.valid = true;
-#endif
-            displayList->Instructions.push_back(command);
-            command.words.w0 = reader->ReadUInt32();
-            command.words.w1 = reader->ReadUInt32();
+        // These are 128-bit commands, the next pair is their second half.
+        commandCount += isExpanded ? 2 : 1;
+
+        if (opcode == endOpcode) {
+            break;
         }
+    }
 
+    if (commandCount > pairCount) {
+        throw std::out_of_range("Display list " + initData->Path + " ends in the middle of a command");
+    }
+
+    for (size_t i = commandCount; i-- > 0;) {
+        uint32_t pair[2];
+        memcpy(pair, words + i * 8, sizeof(pair));
+
+        Gfx& command = displayList->Instructions[i];
+        command.words.w0 = pair[0];
+        command.words.w1 = pair[1];
 #ifdef USE_GBI_TRACE
         command.words.trace.file = initData->Path.c_str();
-        command.words.trace.idx = idx++;
+        command.words.trace.idx = i;
         command.words.trace.valid = true;
 #endif
-
-        displayList->Instructions.push_back(command);
-
-        if (opcode == GetEndOpcodeByUCode(ucode)) {
-            break;
-        }
     }
+    displayList->Instructions.resize(commandCount);
 
     return displayList;
 }
@@ -12,7 +12,7 @@ std::shared_ptr<IResource> ResourceFactoryBinaryJsonV0::ReadResource(std::shared
     auto json = std::make_shared<Json>(initData);
     auto reader = std::get<std::shared_ptr<BinaryReader>>(file->Reader);
 
-    json->DataSize = file->Buffer->size();
+    json->DataSize = file->GetDataSize();
     json->Data = nlohmann::json::parse(reader->ReadCString(), nullptr, true, true);
 
     return json;
@@ -0,0 +1,117 @@
+#include "resource/factory/MeshFactory.h"
+#include "resource/type/Mesh.h"
+#include "spdlog/spdlog.h"
+#include "libultraship/libultra/gbi.h"
+#include <tinyxml2.h>
+
+namespace Fast {
+// Vertices are stored exactly as they're laid out in memory, so the list can be copied in one go.
+static_assert(sizeof(Vtx) == 16, "Vtx no longer matches the binary mesh format");
+
+// The interpreter indexes straight into the vertex list, so bad index data is rejected here, once, at load time.
+static bool MeshHasValidIndices(const std::shared_ptr<Mesh>& mesh, const std::string& path) {
+    if (mesh->IndexList.size() % 3 != 0) {
+        SPDLOG_ERROR("Mesh {} has {} indices, which is not a multiple of three", path, mesh->IndexList.size());
+        return false;
+    }
+
+    for (uint16_t index : mesh->IndexList) {
+        if (index >= mesh->VertexList.size()) {
+            SPDLOG_ERROR("Mesh {} references vertex {} but only has {} vertices", path, index,
+                         mesh->VertexList.size());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<Ship::IResource>
+ResourceFactoryBinaryMeshV0::ReadResource(std::shared_ptr<Ship::File> file,
+                                          std::shared_ptr<Ship::ResourceInitData> initData) {
+    if (!FileHasValidFormatAndReader(file, initData)) {
+        return nullptr;
+    }
+
+    auto mesh = std::make_shared<Mesh>(initData);
+    auto reader = file->GetSpanReader(initData->ByteOrder);
+
+    uint32_t vertexCount = reader.ReadUInt32();
+    if (vertexCount > reader.GetRemaining() / sizeof(Vtx)) {
+        SPDLOG_ERROR("Mesh {} has {} vertices but only {} bytes of data", initData->Path, vertexCount,
+                     reader.GetRemaining());
+        return nullptr;
+    }
+
+    mesh->VertexList.resize(vertexCount);
+    reader.ReadArray(reinterpret_cast<uint8_t*>(mesh->VertexList.data()), vertexCount * sizeof(Vtx));
+
+    // Same layout as the vertex resource, only the first six 16-bit words of each vertex need swapping.
+    if (initData->ByteOrder != Ship::Endianness::Native) {
+        for (auto& vtx : mesh->VertexList) {
+            Ship::ByteSwapArray(reinterpret_cast<uint16_t*>(&vtx), 6);
+        }
+    }
+
+    uint32_t indexCount = reader.ReadUInt32();
+    if (indexCount > reader.GetRemaining() / sizeof(uint16_t)) {
+        SPDLOG_ERROR("Mesh {} has {} indices but only {} bytes of data", initData->Path, indexCount,
+                     reader.GetRemaining());
+        return nullptr;
+    }
+
+    mesh->IndexList.resize(indexCount);
+    reader.ReadArray(mesh->IndexList.data(), indexCount);
+
+    if (!MeshHasValidIndices(mesh, initData->Path)) {
+        return nullptr;
+    }
+
+    return mesh;
+}
+
+std::shared_ptr<Ship::IResource>
+ResourceFactoryXMLMeshV0::ReadResource(std::shared_ptr<Ship::File> file,
+                                       std::shared_ptr<Ship::ResourceInitData> initData) {
+    if (!FileHasValidFormatAndReader(file, initData)) {
+        return nullptr;
+    }
+
+    auto mesh = std::make_shared<Mesh>(initData);
+
+    auto child =
+        std::get<std::shared_ptr<tinyxml2::XMLDocument>>(file->Reader)->FirstChildElement()->FirstChildElement();
+
+    while (child != nullptr) {
+        std::string childName = child->Name();
+
+        if (childName == "Vtx") {
+            Vtx data;
+            data.v.ob[0] = child->IntAttribute("X");
+            data.v.ob[1] = child->IntAttribute("Y");
+            data.v.ob[2] = child->IntAttribute("Z");
+            data.v.flag = 0;
+            data.v.tc[0] = child->IntAttribute("S");
+            data.v.tc[1] = child->IntAttribute("T");
+            data.v.cn[0] = child->IntAttribute("R");
+            data.v.cn[1] = child->IntAttribute("G");
+            data.v.cn[2] = child->IntAttribute("B");
+            data.v.cn[3] = child->IntAttribute("A");
+
+            mesh->VertexList.push_back(data);
+        } else if (childName == "Tri") {
+            mesh->IndexList.push_back(child->UnsignedAttribute("V0"));
+            mesh->IndexList.push_back(child->UnsignedAttribute("V1"));
+            mesh->IndexList.push_back(child->UnsignedAttribute("V2"));
+        }
+
+        child = child->NextSiblingElement();
+    }
+
+    if (!MeshHasValidIndices(mesh, initData->Path)) {
+        return nullptr;
+    }
+
+    return mesh;
+}
+} // namespace Fast
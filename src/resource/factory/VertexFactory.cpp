@@ -5,6 +5,9 @@
 #include <tinyxml2.h>
 
 namespace Fast {
+// The binary format stores each Vtx exactly as it's laid out in memory, so the list can be copied in one go.
+static_assert(sizeof(Vtx) == 16, "Vtx no longer matches the binary vertex format");
+
 std::shared_ptr<Ship::IResource>
 ResourceFactoryBinaryVertexV0::ReadResource(std::shared_ptr<Ship::File> file,
                                             std::shared_ptr<Ship::ResourceInitData> initData) {
@@ -13,24 +16,24 @@ ResourceFactoryBinaryVertexV0::ReadResource(std::shared_ptr<Ship::File> file,
     }
 
     auto vertex = std::make_shared<Vertex>(initData);
-    auto reader = std::get<std::shared_ptr<Ship::BinaryReader>>(file->Reader);
+    auto reader = file->GetSpanReader(initData->ByteOrder);
 
-    uint32_t count = reader->ReadUInt32();
-    vertex->VertexList.reserve(count);
+    uint32_t count = reader.ReadUInt32();
+    if (count > reader.GetRemaining() / sizeof(Vtx)) {
+        SPDLOG_ERROR("Vertex resource {} has {} vertices but only {} bytes of data", initData->Path, count,
+                     reader.GetRemaining());
+        return nullptr;
+    }
 
-    for (uint32_t i = 0; i < count; i++) {
-        Vtx data;
-        data.v.ob[0] = reader->ReadInt16();
-        data.v.ob[1] = reader->ReadInt16();
-        data.v.ob[2] = reader->ReadInt16();
-        data.v.flag = reader->ReadUInt16();
-        data.v.tc[0] = reader->ReadInt16();
-        data.v.tc[1] = reader->ReadInt16();
-        data.v.cn[0] = reader->ReadUByte();
-        data.v.cn[1] = reader->ReadUByte();
-        data.v.cn[2] = reader->ReadUByte();
-        data.v.cn[3] = reader->ReadUByte();
-        vertex->VertexList.push_back(data);
+    vertex->VertexList.resize(count);
+    reader.ReadArray(reinterpret_cast<uint8_t*>(vertex->VertexList.data()), count * sizeof(Vtx));
+
+    // Position, flag and texture coordinates are the first six of the eight 16-bit words in each vertex. The color
+    // bytes after them don't need swapping.
+    if (initData->ByteOrder != Ship::Endianness::Native) {
+        for (auto& vtx : vertex->VertexList) {
+            Ship::ByteSwapArray(reinterpret_cast<uint16_t*>(&vtx), 6);
+        }
     }
 
     return vertex;
@@ -0,0 +1,19 @@
+#include "resource/type/Mesh.h"
+#include "libultraship/libultra/gbi.h"
+
+namespace Fast {
+Mesh::Mesh() : Resource(std::shared_ptr<Ship::ResourceInitData>()) {
+}
+
+Vtx* Mesh::GetPointer() {
+    return VertexList.data();
+}
+
+size_t Mesh::GetPointerSize() {
+    return VertexList.size() * sizeof(Vtx) + IndexList.size() * sizeof(uint16_t);
+}
+
+size_t Mesh::GetVertexCount() const {
+    return VertexList.size();
+}
+} // namespace Fast
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "resource/Resource.h"
+#include <vector>
+
+union Vtx;
+
+namespace Fast {
+// A pre-built indexed triangle list. Drawn as a whole with G_MESH_OTR_HASH or G_MESH_OTR_FILEPATH instead of
+// being split into G_VTX/G_TRI chunks that fit into the RSP vertex buffer.
+class Mesh : public Ship::Resource<Vtx> {
+  public:
+    using Resource::Resource;
+
+    Mesh();
+
+    Vtx* GetPointer() override;
+    size_t GetPointerSize() override;
+    size_t GetVertexCount() const;
+
+    std::vector<Vtx> VertexList;
+    // Three entries per triangle, each one an index into VertexList.
+    std::vector<uint16_t> IndexList;
+};
+} // namespace Fast
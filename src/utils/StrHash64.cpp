@@ -83,6 +83,7 @@
 */
 
 #include <stdint.h>
+#include <string.h>
 
 #define u8 uint8_t
 #define u16 uint16_t
@@ -93,7 +94,7 @@
 #define INITIAL_CRC64 0xffffffffffffffffULL
 
 #define CONST64(n) n##ull
-static const u64 CRC64_Table[256] = {
+static constexpr u64 CRC64_Table[256] = {
     CONST64(0x0000000000000000), CONST64(0x42f0e1eba9ea3693), CONST64(0x85e1c3d753d46d26), CONST64(0xc711223cfa3e5bb5),
     CONST64(0x493366450e42ecdf), CONST64(0x0bc387aea7a8da4c), CONST64(0xccd2a5925d9681f9), CONST64(0x8e224479f47cb76a),
     CONST64(0x9266cc8a1c85d9be), CONST64(0xd0962d61b56fef2d), CONST64(0x17870f5d4f51b498), CONST64(0x5577eeb6e6bb820b),
@@ -160,13 +161,58 @@ static const u64 CRC64_Table[256] = {
     CONST64(0x5dedc41a34bbeeb2), CONST64(0x1f1d25f19d51d821), CONST64(0xd80c07cd676f8394), CONST64(0x9afce626ce85b507)
 };
 
-uint64_t update_crc64(const void* buf, unint len, u64 crc) {
-    const u8* b = (const u8*)buf;
-    unint i;
-    for (i = 0; i < len; i++) {
-        crc = CRC64_Table[(u8)(crc >> 56) ^ *b++] ^ (crc << 8);
+/*
+ * Slice-by-8 tables. CRC64_Slices[k][i] is the CRC of byte i followed by k zero bytes, so eight bytes can be folded
+ * into the CRC with eight independent lookups instead of eight dependent ones. CRC64_Slices[0] is CRC64_Table.
+ */
+struct CRC64_SliceTables {
+    u64 Table[8][256];
+};
+
+static constexpr CRC64_SliceTables MakeCRC64SliceTables() {
+    CRC64_SliceTables tables = {};
+    for (int i = 0; i < 256; i++) {
+        tables.Table[0][i] = CRC64_Table[i];
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            const u64 previous = tables.Table[k - 1][i];
+            tables.Table[k][i] = CRC64_Table[(u8)(previous >> 56)] ^ (previous << 8);
+        }
     }
-    return ~crc;
+    return tables;
+}
+
+static constexpr CRC64_SliceTables CRC64_Slices = MakeCRC64SliceTables();
+
+/* Templated on the byte type so the known-answer checks below can run on string literals at compile time. */
+template <typename Byte> static constexpr u64 crc64_update_raw(const Byte* b, size_t len, u64 crc) {
+    const auto& t = CRC64_Slices.Table;
+    for (; len >= 8; len -= 8, b += 8) {
+        /* This CRC is MSB first, so the bytes are folded in big endian order. */
+        const u64 x = crc ^ (((u64)(u8)b[0] << 56) | ((u64)(u8)b[1] << 48) | ((u64)(u8)b[2] << 40) |
+                             ((u64)(u8)b[3] << 32) | ((u64)(u8)b[4] << 24) | ((u64)(u8)b[5] << 16) |
+                             ((u64)(u8)b[6] << 8) | (u64)(u8)b[7]);
+        crc = t[7][(u8)(x >> 56)] ^ t[6][(u8)(x >> 48)] ^ t[5][(u8)(x >> 40)] ^ t[4][(u8)(x >> 32)] ^
+              t[3][(u8)(x >> 24)] ^ t[2][(u8)(x >> 16)] ^ t[1][(u8)(x >> 8)] ^ t[0][(u8)x];
+    }
+    while (len--) {
+        crc = CRC64_Table[(u8)(crc >> 56) ^ (u8)*b++] ^ (crc << 8);
+    }
+    return crc;
+}
+
+/*
+ * Known answers for CRC64 (the CRC is not inverted). "123456789" covers one 8-byte block and the byte tail; the longer
+ * path covers several blocks followed by a multi-byte tail.
+ */
+static_assert(crc64_update_raw("", 0, INITIAL_CRC64) == CONST64(0xffffffffffffffff));
+static_assert(crc64_update_raw("123456789", 9, INITIAL_CRC64) == CONST64(0x9d13a61c0e5b0ff5));
+static_assert(crc64_update_raw("objects/gameplay_keep/gEffBombExplosion1Tex", 43, INITIAL_CRC64) ==
+              CONST64(0x689eeb5e4be886e1));
+
+uint64_t update_crc64(const void* buf, unint len, u64 crc) {
+    return ~crc64_update_raw((const u8*)buf, len, crc);
 }
 
 u64 crc64(const void* buf, unint len) {
@@ -174,10 +220,6 @@ u64 crc64(const void* buf, unint len) {
 }
 
 u64 CRC64(const char* t) {
-    u64 crc = INITIAL_CRC64;
-    const u8* s = (const u8*)t;
-    while (*s) {
-        crc = CRC64_Table[(u8)(crc >> 56) ^ *s++] ^ (crc << 8);
-    }
-    return crc;
-}
\ No newline at end of file
+    /* strlen is vectorized by the C library, which leaves the CRC loop free to work on eight bytes at a time. */
+    return crc64_update_raw((const u8*)t, strlen(t), INITIAL_CRC64);
+}
@@ -36,7 +36,8 @@ uint32_t Ship::BinaryReader::GetBaseAddress() {
 }
 
 void Ship::BinaryReader::Read(int32_t length) {
-    mStream->Read(length);
+    // The data is discarded, so skip it instead of copying it out of the stream
+    mStream->Seek(length, SeekOffsetType::Current);
 }
 
 void Ship::BinaryReader::Read(char* buffer, int32_t length) {
@@ -5,6 +5,7 @@
 #include <vector>
 #include "endianness.h"
 #include "Stream.h"
+#include "SpanReader.h"
 
 class BinaryReader;
 
@@ -40,6 +41,14 @@ class BinaryReader {
     std::string ReadString();
     std::string ReadCString();
 
+    // Reads count elements with a single stream read, then byte swaps them all at once if needed.
+    template <typename T> void ReadArray(T* dest, size_t count) {
+        mStream->Read(reinterpret_cast<const char*>(dest), count * sizeof(T));
+        if (mEndianness != Endianness::Native) {
+            ByteSwapArray(dest, count);
+        }
+    }
+
     std::vector<char> ToVector();
 
   protected:
@@ -1,5 +1,6 @@
 #include "MemoryStream.h"
 #include <cstring>
+#include <stdexcept>
 
 #ifndef _MSC_VER
 #define memcpy_s(dest, destSize, source, sourceSize) memcpy(dest, source, destSize)
@@ -9,6 +10,7 @@ Ship::MemoryStream::MemoryStream() {
     mBuffer = std::make_shared<std::vector<char>>();
     // mBuffer.reserve(1024 * 16);
     mBufferSize = 0;
+    mBufferOffset = 0;
     mBaseAddress = 0;
 }
 
@@ -24,11 +26,49 @@ Ship::MemoryStream::MemoryStream(std::shared_ptr<std::vector<char>> buffer) : Me
     mBaseAddress = 0;
 }
 
+Ship::MemoryStream::MemoryStream(std::shared_ptr<std::vector<char>> buffer, size_t offset) : MemoryStream() {
+    mBuffer = buffer;
+    mBufferOffset = offset;
+    mBufferSize = buffer->size() - offset;
+    mBaseAddress = 0;
+}
+
 Ship::MemoryStream::~MemoryStream() {
 }
 
+Ship::MemoryStream::MemoryStream(std::shared_ptr<const char> data, size_t size) : MemoryStream() {
+    mView = data;
+    mBufferSize = size;
+    mBaseAddress = 0;
+}
+
 uint64_t Ship::MemoryStream::GetLength() {
-    return mBuffer->size();
+    if (mView != nullptr) {
+        return mBufferSize;
+    }
+
+    return mBuffer->size() - mBufferOffset;
+}
+
+const char* Ship::MemoryStream::GetReadPointer(size_t length) {
+    if (mView != nullptr) {
+        if (mBaseAddress + length > mBufferSize) {
+            throw std::out_of_range("MemoryStream: Read past the end of the stream");
+        }
+        return mView.get() + mBaseAddress;
+    }
+
+    return &mBuffer->at(mBufferOffset + mBaseAddress);
+}
+
+void Ship::MemoryStream::DetachView() {
+    if (mView == nullptr) {
+        return;
+    }
+
+    mBuffer = std::make_shared<std::vector<char>>(mView.get(), mView.get() + mBufferSize);
+    mBufferOffset = 0;
+    mView = nullptr;
 }
 
 void Ship::MemoryStream::Seek(int32_t offset, SeekOffsetType seekType) {
@@ -44,42 +84,54 @@ void Ship::MemoryStream::Seek(int32_t offset, SeekOffsetType seekType) {
 std::unique_ptr<char[]> Ship::MemoryStream::Read(size_t length) {
     std::unique_ptr<char[]> result = std::make_unique<char[]>(length);
 
-    memcpy_s(result.get(), length, &mBuffer->at(mBaseAddress), length);
+    memcpy_s(result.get(), length, GetReadPointer(length), length);
     mBaseAddress += length;
 
     return result;
 }
 
 void Ship::MemoryStream::Read(const char* dest, size_t length) {
-    memcpy_s((void*)dest, length, &mBuffer->at(mBaseAddress), length);
+    memcpy_s((void*)dest, length, GetReadPointer(length), length);
     mBaseAddress += length;
 }
 
 int8_t Ship::MemoryStream::ReadByte() {
-    return mBuffer->at(mBaseAddress++);
+    int8_t value = *GetReadPointer(1);
+    mBaseAddress++;
+    return value;
 }
 
 void Ship::MemoryStream::Write(char* srcBuffer, size_t length) {
-    if (mBaseAddress + length >= mBuffer->size()) {
-        mBuffer->resize(mBaseAddress + length);
+    DetachView();
+    if (mBufferOffset + mBaseAddress + length >= mBuffer->size()) {
+        mBuffer->resize(mBufferOffset + mBaseAddress + length);
         mBufferSize += length;
     }
 
-    memcpy_s(&((*mBuffer)[mBaseAddress]), length, srcBuffer, length);
+    memcpy_s(&((*mBuffer)[mBufferOffset + mBaseAddress]), length, srcBuffer, length);
     mBaseAddress += length;
 }
 
 void Ship::MemoryStream::WriteByte(int8_t value) {
-    if (mBaseAddress >= mBuffer->size()) {
-        mBuffer->resize(mBaseAddress + 1);
+    DetachView();
+    if (mBufferOffset + mBaseAddress >= mBuffer->size()) {
+        mBuffer->resize(mBufferOffset + mBaseAddress + 1);
         mBufferSize = mBaseAddress;
     }
 
-    mBuffer->at(mBaseAddress++) = value;
+    mBuffer->at(mBufferOffset + mBaseAddress++) = value;
 }
 
 std::vector<char> Ship::MemoryStream::ToVector() {
-    return *mBuffer;
+    if (mView != nullptr) {
+        return std::vector<char>(mView.get(), mView.get() + mBufferSize);
+    }
+
+    if (mBufferOffset == 0) {
+        return *mBuffer;
+    }
+
+    return std::vector<char>(mBuffer->begin() + mBufferOffset, mBuffer->end());
 }
 
 void Ship::MemoryStream::Flush() {
@@ -10,6 +10,10 @@ class MemoryStream : public Stream {
     MemoryStream();
     MemoryStream(char* nBuffer, size_t nBufferSize);
     MemoryStream(std::shared_ptr<std::vector<char>> buffer);
+    // Views the buffer starting at offset without copying it. Offset 0 of the stream is offset in the buffer.
+    MemoryStream(std::shared_ptr<std::vector<char>> buffer, size_t offset);
+    // Reads memory owned by someone else without copying it. The data is only copied if the stream is written to.
+    MemoryStream(std::shared_ptr<const char> data, size_t size);
     ~MemoryStream();
 
     uint64_t GetLength() override;
@@ -29,7 +33,12 @@ class MemoryStream : public Stream {
     void Close() override;
 
   protected:
+    const char* GetReadPointer(size_t length);
+    void DetachView();
+
     std::shared_ptr<std::vector<char>> mBuffer;
     std::size_t mBufferSize;
+    std::size_t mBufferOffset;
+    std::shared_ptr<const char> mView;
 };
 } // namespace Ship
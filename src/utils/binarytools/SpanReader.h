@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "endianness.h"
+#include "Stream.h"
+
+namespace Ship {
+
+// Swaps the byte order of every element in place. Kept as a plain loop over same-sized integers so the compiler can
+// vectorize it.
+template <typename T> inline void ByteSwapArray(T* data, size_t count) {
+    static_assert(std::is_arithmetic_v<T>, "ByteSwapArray only supports arithmetic types");
+
+    if constexpr (sizeof(T) == 2) {
+        auto* words = reinterpret_cast<uint16_t*>(data);
+        for (size_t i = 0; i < count; i++) {
+            words[i] = BSWAP16(words[i]);
+        }
+    } else if constexpr (sizeof(T) == 4) {
+        auto* words = reinterpret_cast<uint32_t*>(data);
+        for (size_t i = 0; i < count; i++) {
+            words[i] = BSWAP32(words[i]);
+        }
+    } else if constexpr (sizeof(T) == 8) {
+        auto* words = reinterpret_cast<uint64_t*>(data);
+        for (size_t i = 0; i < count; i++) {
+            words[i] = BSWAP64(words[i]);
+        }
+    }
+}
+
+// Non-virtual reader over memory that is already loaded. Reads the same encoding as BinaryReader, but every read is
+// inline, bounds checked once, and arrays can be read and byte swapped in bulk. Does not own the memory it reads.
+class SpanReader {
+  public:
+    SpanReader(const char* data, size_t size, Endianness endianness = Endianness::Native)
+        : mData(data), mSize(size), mPosition(0), mEndianness(endianness) {
+    }
+
+    void SetEndianness(Endianness endianness) {
+        mEndianness = endianness;
+    }
+
+    Endianness GetEndianness() const {
+        return mEndianness;
+    }
+
+    size_t GetLength() const {
+        return mSize;
+    }
+
+    size_t GetBaseAddress() const {
+        return mPosition;
+    }
+
+    size_t GetRemaining() const {
+        return mSize - mPosition;
+    }
+
+    const char* GetCurrent() const {
+        return mData + mPosition;
+    }
+
+    void Seek(int32_t offset, SeekOffsetType seekType) {
+        size_t position = mPosition;
+        if (seekType == SeekOffsetType::Start) {
+            position = offset;
+        } else if (seekType == SeekOffsetType::Current) {
+            position += offset;
+        } else if (seekType == SeekOffsetType::End) {
+            position = mSize - 1 - offset;
+        }
+
+        if (position > mSize) {
+            throw std::out_of_range("SpanReader::Seek(): Position out of range");
+        }
+        mPosition = position;
+    }
+
+    void Read(char* buffer, size_t length) {
+        Check(length);
+        memcpy(buffer, mData + mPosition, length);
+        mPosition += length;
+    }
+
+    template <typename T> T Read() {
+        static_assert(std::is_arithmetic_v<T>, "SpanReader::Read only supports arithmetic types");
+
+        T result;
+        Read(reinterpret_cast<char*>(&result), sizeof(T));
+        if constexpr (sizeof(T) > 1) {
+            if (mEndianness != Endianness::Native) {
+                ByteSwapArray(&result, 1);
+            }
+        }
+        return result;
+    }
+
+    // Reads count elements straight into dest, then byte swaps them all at once if needed.
+    template <typename T> void ReadArray(T* dest, size_t count) {
+        static_assert(std::is_arithmetic_v<T>, "SpanReader::ReadArray only supports arithmetic types");
+
+        if (count > GetRemaining() / sizeof(T)) {
+            throw std::out_of_range("SpanReader::ReadArray(): Read past the end of the buffer");
+        }
+
+        Read(reinterpret_cast<char*>(dest), count * sizeof(T));
+        if constexpr (sizeof(T) > 1) {
+            if (mEndianness != Endianness::Native) {
+                ByteSwapArray(dest, count);
+            }
+        }
+    }
+
+    char ReadChar() {
+        return Read<char>();
+    }
+
+    int8_t ReadInt8() {
+        return Read<int8_t>();
+    }
+
+    int16_t ReadInt16() {
+        return Read<int16_t>();
+    }
+
+    int32_t ReadInt32() {
+        return Read<int32_t>();
+    }
+
+    int64_t ReadInt64() {
+        return Read<int64_t>();
+    }
+
+    uint8_t ReadUByte() {
+        return Read<uint8_t>();
+    }
+
+    uint16_t ReadUInt16() {
+        return Read<uint16_t>();
+    }
+
+    uint32_t ReadUInt32() {
+        return Read<uint32_t>();
+    }
+
+    uint64_t ReadUInt64() {
+        return Read<uint64_t>();
+    }
+
+    // Same as BinaryReader, a NaN is treated as a read error.
+    float ReadFloat() {
+        float result = Read<float>();
+        if (std::isnan(result)) {
+            throw std::runtime_error("SpanReader::ReadFloat(): Error reading stream");
+        }
+        return result;
+    }
+
+    double ReadDouble() {
+        double result = Read<double>();
+        if (std::isnan(result)) {
+            throw std::runtime_error("SpanReader::ReadDouble(): Error reading stream");
+        }
+        return result;
+    }
+
+    std::string ReadString() {
+        int32_t numChars = ReadInt32();
+        if (numChars < 0) {
+            throw std::out_of_range("SpanReader::ReadString(): Negative string length");
+        }
+
+        Check(numChars);
+        std::string result(mData + mPosition, numChars);
+        mPosition += numChars;
+        return result;
+    }
+
+    // Reads up to and including the terminator, or to the end of the buffer if there is none.
+    std::string ReadCString() {
+        const char* start = mData + mPosition;
+        const void* end = memchr(start, '\0', GetRemaining());
+        size_t length = end != nullptr ? static_cast<const char*>(end) - start + 1 : GetRemaining();
+
+        std::string result(start, length);
+        mPosition += length;
+        return result;
+    }
+
+  private:
+    void Check(size_t length) const {
+        if (length > GetRemaining()) {
+            throw std::out_of_range("SpanReader: Read past the end of the buffer");
+        }
+    }
+
+    const char* mData;
+    size_t mSize;
+    size_t mPosition;
+    Endianness mEndianness;
+};
+} // namespace Ship
@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Ship {
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (mData != nullptr) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle != nullptr) {
+        CloseHandle(mMappingHandle);
+    }
+    if (mFileHandle != nullptr) {
+        CloseHandle(mFileHandle);
+    }
+#else
+    if (mData != nullptr) {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+    auto mappedFile = std::shared_ptr<MappedFile>(new MappedFile());
+
+#ifdef _WIN32
+    // Sharing delete access lets the file be replaced on disk (e.g. when an archive is rewritten) once it's unmapped.
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    mappedFile->mFileHandle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return nullptr;
+    }
+
+    mappedFile->mMappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappedFile->mMappingHandle == nullptr) {
+        return nullptr;
+    }
+
+    mappedFile->mData = static_cast<const char*>(MapViewOfFile(mappedFile->mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (mappedFile->mData == nullptr) {
+        return nullptr;
+    }
+    mappedFile->mSize = static_cast<size_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return nullptr;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(file);
+        return nullptr;
+    }
+
+    // The mapping keeps its own reference to the file, so the descriptor isn't needed past this point.
+    void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    mappedFile->mData = static_cast<const char*>(data);
+    mappedFile->mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return mappedFile;
+}
+
+const char* MappedFile::GetData() const {
+    return mData;
+}
+
+size_t MappedFile::GetSize() const {
+    return mSize;
+}
+} // namespace Ship
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace Ship {
+// Read-only memory mapping of a whole file. The mapping stays valid for as long as the object is alive, even if the
+// file is replaced on disk in the meantime. Windows doesn't allow replacing a file while it's mapped.
+class MappedFile {
+  public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns nullptr if the file doesn't exist, is empty, or can't be mapped on this platform.
+    static std::shared_ptr<MappedFile> Open(const std::string& path);
+
+    const char* GetData() const;
+    size_t GetSize() const;
+
+  private:
+    MappedFile() = default;
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
+} // namespace Ship
@@ -2,6 +2,13 @@
 #include <imgui.h>
 #include "public/bridge/consolevariablebridge.h"
 #include "spdlog/spdlog.h"
+#include "Context.h"
+#include "resource/ResourceManager.h"
+#include "graphic/Fast3D/Fast3dWindow.h"
+#ifdef GFX_OPCODE_PROFILER
+#include <algorithm>
+#include <cstring>
+#endif
 
 namespace Ship {
 StatsWindow::~StatsWindow() {
@@ -29,8 +36,137 @@ void StatsWindow::DrawElement() {
 #endif
     ImGui::Text("Status: %.3f ms/frame (%.1f FPS)", deltatime * 1000.0f, framerate);
     ImGui::PopStyleColor();
+
+    DrawResourceCacheStats();
+
+    auto window = std::dynamic_pointer_cast<Fast::Fast3dWindow>(Context::GetInstance()->GetWindow());
+    if (window == nullptr) {
+        return;
+    }
+
+    auto interpreter = window->GetInterpreterWeak().lock();
+    if (interpreter == nullptr) {
+        return;
+    }
+
+    DrawVertexCacheStats(*interpreter);
+#ifdef GFX_OPCODE_PROFILER
+    DrawOpcodeProfile(*interpreter);
+#endif
 }
 
+void StatsWindow::DrawResourceCacheStats() {
+    auto resourceManager = Context::GetInstance()->GetResourceManager();
+    if (resourceManager == nullptr) {
+        return;
+    }
+
+    const size_t budget = resourceManager->GetMemoryBudget();
+    if (budget == 0) {
+        ImGui::Text("Resource Cache: %.1f MB", resourceManager->GetResidentBytes() / (1024.0 * 1024.0));
+        return;
+    }
+
+    ImGui::Text("Resource Cache: %.1f/%.1f MB, %zu evicted (%.1f MB)",
+                resourceManager->GetResidentBytes() / (1024.0 * 1024.0), budget / (1024.0 * 1024.0),
+                resourceManager->GetEvictedCount(), resourceManager->GetEvictedBytes() / (1024.0 * 1024.0));
+}
+
+void StatsWindow::DrawVertexCacheStats(const Fast::Interpreter& interpreter) {
+    const Fast::GfxVertexCache& cache = interpreter.mVertexCache;
+    if (cache.budget_bytes == 0) {
+        return;
+    }
+
+    const uint64_t lookups = cache.hits + cache.misses;
+    const double hitRate = lookups > 0 ? cache.hits * 100.0 / lookups : 0.0;
+    ImGui::Text("Vertex Cache: %.1f%% hits (%llu/%llu), %llu evictions", hitRate, (unsigned long long)cache.hits,
+                (unsigned long long)lookups, (unsigned long long)cache.evictions);
+    ImGui::Text("Vertex Cache: %zu entries, %.1f/%.1f KB", cache.map.size(), cache.used_bytes / 1024.0,
+                cache.budget_bytes / 1024.0);
+}
+
+#ifdef GFX_OPCODE_PROFILER
+void StatsWindow::DrawOpcodeProfile(const Fast::Interpreter& interpreter) {
+    if (!ImGui::CollapsingHeader("GBI Opcode Profile")) {
+        return;
+    }
+
+    const Fast::GfxProfiler& profiler = interpreter.mProfiler;
+    auto stats = profiler.GetLastFrame();
+    const uint64_t totalNs = profiler.GetLastFrameNanoseconds();
+
+    ImGui::Text("Interpreter: %.3f ms/frame", totalNs / 1000000.0);
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV")) {
+        const auto path = Context::GetPathRelativeToAppDirectory("gbi_profile.csv");
+        if (profiler.ExportCsv(path)) {
+            SPDLOG_INFO("Exported opcode profile to {}", path);
+        }
+    }
+
+    constexpr ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders |
+                                      ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("OpcodeProfile", 6, flags, ImVec2(0.0f, 300.0f))) {
+        return;
+    }
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Ucode");
+    ImGui::TableSetupColumn("Opcode");
+    ImGui::TableSetupColumn("Name");
+    ImGui::TableSetupColumn("Count");
+    ImGui::TableSetupColumn("Time (us)",
+                            ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+    ImGui::TableSetupColumn("% Frame");
+    ImGui::TableHeadersRow();
+
+    if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs(); sortSpecs->SpecsCount > 0) {
+        const auto& spec = sortSpecs->Specs[0];
+        const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+        std::stable_sort(stats.begin(), stats.end(), [&spec, ascending](const auto& a, const auto& b) {
+            int cmp = 0;
+            switch (spec.ColumnIndex) {
+                case 0:
+                    cmp = (int)a.ucode - (int)b.ucode;
+                    break;
+                case 1:
+                    cmp = (int)(uint8_t)a.opcode - (int)(uint8_t)b.opcode;
+                    break;
+                case 2:
+                    cmp = strcmp(a.name, b.name);
+                    break;
+                case 3:
+                    cmp = (a.count > b.count) - (a.count < b.count);
+                    break;
+                default:
+                    cmp = (a.nanoseconds > b.nanoseconds) - (a.nanoseconds < b.nanoseconds);
+                    break;
+            }
+            return ascending ? cmp < 0 : cmp > 0;
+        });
+    }
+
+    for (const auto& entry : stats) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(Fast::GfxProfiler::GetUcodeName(entry.ucode));
+        ImGui::TableNextColumn();
+        ImGui::Text("0x%02X", (uint8_t)entry.opcode);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(entry.name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", (unsigned long long)entry.count);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", entry.nanoseconds / 1000.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", totalNs > 0 ? entry.nanoseconds * 100.0 / totalNs : 0.0);
+    }
+
+    ImGui::EndTable();
+}
+#endif
+
 void StatsWindow::UpdateElement() {
 }
 } // namespace Ship
@@ -2,6 +2,10 @@
 
 #include "window/gui/GuiWindow.h"
 
+namespace Fast {
+class Interpreter;
+}
+
 namespace Ship {
 class StatsWindow : public GuiWindow {
   public:
@@ -12,5 +16,10 @@ class StatsWindow : public GuiWindow {
     void InitElement() override;
     void DrawElement() override;
     void UpdateElement() override;
+    void DrawResourceCacheStats();
+    void DrawVertexCacheStats(const Fast::Interpreter& interpreter);
+#ifdef GFX_OPCODE_PROFILER
+    void DrawOpcodeProfile(const Fast::Interpreter& interpreter);
+#endif
 };
 } // namespace Ship
\ No newline at end of file
@@ -12,7 +12,7 @@ std::shared_ptr<IResource> ResourceFactoryBinaryFontV0::ReadResource(std::shared
     auto font = std::make_shared<Font>(initData);
     auto reader = std::get<std::shared_ptr<BinaryReader>>(file->Reader);
 
-    font->DataSize = file->Buffer->size();
+    font->DataSize = file->GetDataSize();
 
     font->Data = new char[font->DataSize];
     reader->Read(font->Data, font->DataSize);
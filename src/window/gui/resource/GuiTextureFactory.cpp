@@ -13,11 +13,11 @@ ResourceFactoryBinaryGuiTextureV0::ReadResource(std::shared_ptr<File> file,
     auto guiTexture = std::make_shared<GuiTexture>(initData);
     auto reader = std::get<std::shared_ptr<BinaryReader>>(file->Reader);
 
-    guiTexture->DataSize = file->Buffer->size();
+    guiTexture->DataSize = file->GetDataSize();
     guiTexture->Metadata.Width = 0;
     guiTexture->Metadata.Height = 0;
     guiTexture->Data =
-        stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file->Buffer->data()), guiTexture->DataSize,
+        stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file->GetData()), guiTexture->DataSize,
                               &guiTexture->Metadata.Width, &guiTexture->Metadata.Height, nullptr, 4);
 
     if (guiTexture->Data == nullptr) {